@@ -0,0 +1,261 @@
+#include <algorithm>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "ai.hpp"
+#include "board.hpp"
+
+using namespace blit;
+
+// pattern rotated and packed into rows, bit x of rows[y] is set for a tile at pos + (x, y)
+struct PieceMask {
+    RowMask rows[4]{0};
+    int8_t bottom[4]{-1, -1, -1, -1}; // lowest tile in each column, -1 if none
+    int minX = 4, maxX = -1;
+    int minY = 4, maxY = -1;
+};
+
+struct PieceMasks {
+    PieceMasks() {
+        for(int id = 0; id < numBlocks; id++) {
+            auto &block = blocks[id];
+
+            for(int rot = 0; rot < 4; rot++) {
+                auto &mask = masks[id][rot];
+
+                for(int y = 0; y < block.height; y++) {
+                    for(int x = 0; x < block.width; x++) {
+                        if(!block.hasTile(x, y))
+                            continue;
+
+                        auto rotPos = rotateIt(Point(x, y), block.width, block.height, rot);
+                        mask.rows[rotPos.y] |= RowMask(1) << rotPos.x;
+                        mask.bottom[rotPos.x] = std::max(mask.bottom[rotPos.x], int8_t(rotPos.y));
+
+                        mask.minX = std::min(mask.minX, int(rotPos.x));
+                        mask.maxX = std::max(mask.maxX, int(rotPos.x));
+                        mask.minY = std::min(mask.minY, int(rotPos.y));
+                        mask.maxY = std::max(mask.maxY, int(rotPos.y));
+                    }
+                }
+            }
+        }
+    }
+
+    PieceMask masks[numBlocks][4];
+};
+
+static const PieceMask &getPieceMask(int blockId, int rot) {
+    static const PieceMasks pieceMasks;
+    return pieceMasks.masks[blockId][rot];
+}
+
+static inline int popCount(uint32_t v) {
+#ifdef _MSC_VER
+    return __popcnt(v);
+#else
+    return __builtin_popcount(v);
+#endif
+}
+
+static inline int popCount(uint64_t v) {
+#ifdef _MSC_VER
+    return int(__popcnt64(v));
+#else
+    return __builtin_popcountll(v);
+#endif
+}
+
+static inline int countTrailingZeros(uint32_t v) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, v);
+    return index;
+#else
+    return __builtin_ctz(v);
+#endif
+}
+
+static inline int countTrailingZeros(uint64_t v) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, v);
+    return index;
+#else
+    return __builtin_ctzll(v);
+#endif
+}
+
+// a row plus a wall bit either side
+using WideMask = std::conditional<gridWidth <= 30, uint32_t, uint64_t>::type;
+
+BitBoard makeBitBoard(const Board &board) {
+    BitBoard bitBoard;
+
+    for(int y = 0; y < gridHeight; y++)
+        bitBoard.rows[y] = board.getRowMask(y);
+
+    return bitBoard;
+}
+
+int clearFullRows(BitBoard &board) {
+    int outY = gridHeight - 1;
+
+    for(int y = gridHeight - 1; y >= 0; y--) {
+        if(board.rows[y] != BitBoard::fullRow)
+            board.rows[outY--] = board.rows[y];
+    }
+
+    int cleared = outY + 1;
+
+    for(; outY >= 0; outY--)
+        board.rows[outY] = 0;
+
+    return cleared;
+}
+
+float evaluateBoard(const BitBoard &board, int linesCleared, const AIWeights &weights) {
+    const WideMask full = BitBoard::fullRow;
+    const WideMask walls = 1 | (WideMask(1) << (gridWidth + 1)); // for a row shifted left by one
+
+    int height = 0, holes = 0, rowTransitions = 0, bumpiness = 0, wells = 0;
+
+    WideMask covered = 0; // columns with a tile in this row or any above
+    WideMask lastWells = 0;
+    int wellDepth[gridWidth]{0};
+
+    // top to bottom, most features are a few operations on the whole row
+    for(int y = 0; y < gridHeight; y++) {
+        WideMask row = board.rows[y];
+
+        // empty, but something above
+        holes += popCount(covered & ~row);
+
+        covered |= row;
+
+        // every covered column is at least this high, so this adds up to the sum of heights
+        height += popCount(covered);
+
+        // neighbouring columns differ where one is covered and the other isn't yet
+        bumpiness += popCount((covered ^ (covered >> 1)) & (full >> 1));
+
+        // skip the empty rows above the stack, they're all the same
+        if(!covered)
+            continue;
+
+        WideMask withWalls = (row << 1) | walls;
+        rowTransitions += popCount((withWalls ^ (withWalls >> 1)) & ((full << 1) | 1));
+
+        // open cells with filled cells (or walls) either side
+        WideMask wellCells = ~covered & full & (withWalls >> 2) & withWalls;
+
+        for(WideMask ended = lastWells & ~wellCells; ended; ended &= ended - 1)
+            wellDepth[countTrailingZeros(ended)] = 0;
+
+        for(WideMask cells = wellCells; cells; cells &= cells - 1)
+            wells += ++wellDepth[countTrailingZeros(cells)];
+
+        lastWells = wellCells;
+    }
+
+    return height * weights.height
+         + holes * weights.holes
+         + rowTransitions * weights.rowTransitions
+         + bumpiness * weights.bumpiness
+         + wells * weights.wells
+         + linesCleared * weights.lines;
+}
+
+int findPlacements(const BitBoard &board, int blockId, const AIWeights &weights, Placement *placements) {
+    int count = 0;
+
+    // highest filled cell in each column, a straight drop always lands on one of these
+    int columnTops[gridWidth];
+    RowMask found = 0;
+
+    for(auto &top : columnTops)
+        top = gridHeight;
+
+    for(int y = 0; y < gridHeight && found != BitBoard::fullRow; y++) {
+        for(WideMask cells = board.rows[y] & ~found; cells; cells &= cells - 1)
+            columnTops[countTrailingZeros(cells)] = y;
+
+        found |= board.rows[y];
+    }
+
+    for(int rot = 0; rot < 4; rot++) {
+        auto &mask = getPieceMask(blockId, rot);
+
+        for(int x = -mask.minX; x + mask.maxX < gridWidth; x++) {
+            RowMask rows[4];
+            for(int i = 0; i < 4; i++)
+                rows[i] = x < 0 ? mask.rows[i] >> -x : mask.rows[i] << x;
+
+            // land on whichever column is hit first
+            int y = gridHeight;
+            for(int px = mask.minX; px <= mask.maxX; px++) {
+                if(mask.bottom[px] != -1)
+                    y = std::min(y, columnTops[x + px] - 1 - mask.bottom[px]);
+            }
+
+            // landed (partly) off the top, that's game over
+            if(y + mask.minY < 0)
+                continue;
+
+            BitBoard placed = board;
+            for(int py = mask.minY; py <= mask.maxY; py++)
+                placed.rows[y + py] |= rows[py];
+
+            int cleared = clearFullRows(placed);
+
+            // also game over if anything is left in the hidden row
+            if(placed.rows[0])
+                continue;
+
+            auto &placement = placements[count++];
+            placement.x = x;
+            placement.y = y;
+            placement.rot = rot;
+            placement.score = evaluateBoard(placed, cleared, weights);
+            placement.valid = true;
+        }
+    }
+
+    return count;
+}
+
+Placement findBestPlacement(const BitBoard &board, int blockId, const AIWeights &weights) {
+    Placement placements[maxPlacements];
+    int count = findPlacements(board, blockId, weights, placements);
+
+    Placement best;
+
+    for(int i = 0; i < count; i++) {
+        if(!best.valid || placements[i].score > best.score)
+            best = placements[i];
+    }
+
+    return best;
+}
+
+int applyPlacement(BitBoard &board, int blockId, const Placement &placement) {
+    auto &mask = getPieceMask(blockId, placement.rot);
+
+    for(int py = mask.minY; py <= mask.maxY; py++) {
+        int y = placement.y + py;
+        if(y >= 0 && y < gridHeight)
+            board.rows[y] |= placement.x < 0 ? mask.rows[py] >> -placement.x : mask.rows[py] << placement.x;
+    }
+
+    return clearFullRows(board);
+}
+
+bool playBestPlacement(Board &board, const AIWeights &weights) {
+    board.spawnBlock();
+
+    auto placement = findBestPlacement(makeBitBoard(board), board.getFallingBlock().id, weights);
+
+    return placement.valid && board.dropBlock(placement.x, placement.rot);
+}
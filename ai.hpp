@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+
+#include "blocks.hpp"
+
+// weights for each board feature, positive is good
+struct AIWeights {
+    float height = -0.51f;         // sum of column heights
+    float holes = -2.0f;           // empty cells with something above them
+    float rowTransitions = -0.3f;  // filled/empty changes along each row (walls count as filled)
+    float bumpiness = -0.18f;      // sum of height differences between neighbouring columns
+    float wells = -0.25f;          // open cells with filled neighbours, deeper cells count more
+    float lines = 0.3f;            // lines cleared by the placement
+};
+
+// one bit per cell, bit x of rows[y] is set if the cell is filled
+struct BitBoard {
+    static const RowMask fullRow = fullRowMask;
+
+    RowMask rows[gridHeight]{0};
+};
+
+class Board;
+
+struct Placement {
+    int8_t x = 0, rot = 0;
+    int8_t y = 0; // where it lands
+    float score = 0.0f;
+    bool valid = false;
+};
+
+// every rotation/column a block can be dropped into
+static const int maxPlacements = 4 * gridWidth;
+
+BitBoard makeBitBoard(const Board &board);
+
+// removes full rows, returns how many were removed
+int clearFullRows(BitBoard &board);
+
+float evaluateBoard(const BitBoard &board, int linesCleared, const AIWeights &weights);
+
+// fills placements with every position the block can be dropped into that doesn't lose, returns the count
+int findPlacements(const BitBoard &board, int blockId, const AIWeights &weights, Placement *placements);
+
+Placement findBestPlacement(const BitBoard &board, int blockId, const AIWeights &weights);
+
+// adds the block where the placement landed and clears full rows, returns how many were cleared
+int applyPlacement(BitBoard &board, int blockId, const Placement &placement);
+
+// spawns the next block and drops it at the best placement, returns false if there wasn't one
+bool playBestPlacement(Board &board, const AIWeights &weights);
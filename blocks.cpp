@@ -0,0 +1,58 @@
+#include <algorithm>
+
+#include "blocks.hpp"
+
+using namespace blit;
+
+// '#' for a tile, two rows
+static constexpr uint8_t makePattern(const char *row0, const char *row1) {
+    uint8_t pattern = 0;
+
+    for(int x = 0; row0[x]; x++)
+        pattern |= (row0[x] == '#') << x;
+
+    for(int x = 0; row1[x]; x++)
+        pattern |= (row1[x] == '#') << (x + 4);
+
+    return pattern;
+}
+
+const Block blocks[numBlocks]{
+    //Z
+    {makePattern("##.", ".##"), 3, 2},
+    //L
+    {makePattern("..#", "###"), 3, 2},
+    //O
+    {makePattern("##", "##"), 2, 2},
+    //S
+    {makePattern(".##", "##."), 3, 2},
+    //I
+    {makePattern("....", "####"), 4, 2},
+    //J
+    {makePattern("#", "###"), 3, 2},
+    //T
+    {makePattern(".#", "###"), 3, 2}
+};
+
+Point rotateIt(Point pos, int w, int h, int rot) {
+    // doubling everthing for precision
+    int center = (std::max(w, h) - 1);
+
+    int rX = pos.x * 2 - center;
+    int rY = pos.y * 2 - center;
+
+    if(rot == 1) {
+        int tmp = rX;
+        rX = -rY;
+        rY = tmp;
+    } else if(rot == 2) {
+        rX = -rX;
+        rY = -rY;
+    } else if(rot == 3) {
+        int tmp = rX;
+        rX = rY;
+        rY = -tmp;
+    }
+
+    return Point((rX + center) / 2, (rY + center) / 2);
+}
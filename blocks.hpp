@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+#include "types/point.hpp"
+
+// playfield size, row 0 is hidden above the top of the screen
+// can be overridden for stress testing the headless tools, the game's layout assumes the default
+#ifndef FOURBLOCK_GRID_WIDTH
+#define FOURBLOCK_GRID_WIDTH 10
+#endif
+#ifndef FOURBLOCK_GRID_HEIGHT
+#define FOURBLOCK_GRID_HEIGHT 16
+#endif
+
+static const int gridWidth = FOURBLOCK_GRID_WIDTH, gridHeight = FOURBLOCK_GRID_HEIGHT;
+
+static_assert(gridWidth >= 4 && gridWidth <= 62, "the AI needs a bit per column and two for walls in 64 bits");
+static_assert(gridHeight >= 4 && gridHeight <= 127, "positions are stored in int8_t");
+
+// one bit per column
+using RowMask = std::conditional<gridWidth <= 16, uint16_t,
+                std::conditional<gridWidth <= 32, uint32_t, uint64_t>::type>::type;
+
+static const RowMask fullRowMask = RowMask(~RowMask(0)) >> (sizeof(RowMask) * 8 - gridWidth);
+
+struct Block {
+    uint8_t pattern; // bit x + y * 4 is set for each tile
+    uint8_t width, height;
+
+    bool hasTile(int x, int y) const {
+        return pattern & (1 << (x + y * 4));
+    }
+};
+
+static const int numBlocks = 7;
+extern const Block blocks[numBlocks];
+
+blit::Point rotateIt(blit::Point pos, int w, int h, int rot);
@@ -0,0 +1,725 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "board.hpp"
+
+using namespace blit;
+
+// garbage sent for clearing 0-4 lines at once
+static const int garbageForLines[]{0, 0, 1, 2, 4};
+
+// row scans, 16 bytes (32 cells) at a time on hosts with SIMD, then 4 bytes at a time
+// the default board only has 5 bytes per row so the device just uses the word loop
+
+// every cell (nibble) is non-zero
+static bool isRowFull(const uint8_t *row, int bytes) {
+    int i = 0;
+
+#if defined(__SSE2__) || defined(_M_X64)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lowMask = _mm_set1_epi8(0x0F), highMask = _mm_set1_epi8(char(0xF0));
+
+    for(; i + 16 <= bytes; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i));
+        __m128i emptyCells = _mm_or_si128(_mm_cmpeq_epi8(_mm_and_si128(v, lowMask), zero), _mm_cmpeq_epi8(_mm_and_si128(v, highMask), zero));
+
+        if(_mm_movemask_epi8(emptyCells))
+            return false;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for(; i + 16 <= bytes; i += 16) {
+        uint8x16_t v = vld1q_u8(row + i);
+        uint8x16_t filled = vandq_u8(vtstq_u8(v, vdupq_n_u8(0x0F)), vtstq_u8(v, vdupq_n_u8(0xF0)));
+
+        if(vminvq_u8(filled) == 0)
+            return false;
+    }
+#endif
+
+    for(; i + 4 <= bytes; i += 4) {
+        uint32_t v;
+        memcpy(&v, row + i, 4);
+
+        // fold each nibble into its low bit
+        if(((v | v >> 1 | v >> 2 | v >> 3) & 0x11111111) != 0x11111111)
+            return false;
+    }
+
+    for(; i < bytes; i++) {
+        if(!(row[i] & 0x0F) || !(row[i] & 0xF0))
+            return false;
+    }
+
+    return true;
+}
+
+static bool isRowEmpty(const uint8_t *row, int bytes) {
+    int i = 0;
+
+#if defined(__SSE2__) || defined(_M_X64)
+    for(; i + 16 <= bytes; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i));
+
+        if(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) != 0xFFFF)
+            return false;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for(; i + 16 <= bytes; i += 16) {
+        if(vmaxvq_u8(vld1q_u8(row + i)))
+            return false;
+    }
+#endif
+
+    for(; i + 4 <= bytes; i += 4) {
+        uint32_t v;
+        memcpy(&v, row + i, 4);
+
+        if(v)
+            return false;
+    }
+
+    for(; i < bytes; i++) {
+        if(row[i])
+            return false;
+    }
+
+    return true;
+}
+
+void Board::reset(uint32_t seed) {
+    setRandomSeed(seed);
+
+    for(auto &cell : grid)
+        cell = 0;
+
+    for(auto &row : rowFalling)
+        row = 0;
+
+    for(auto &height : columnHeights)
+        height = 0;
+
+    blockFalling.id = -1;
+
+    bag = 0;
+    for(auto &block : queue)
+        block = nextBagBlock();
+
+    score = 0;
+    lines = 0;
+    combo = 0;
+    lastWasTetris = false;
+
+    numClearedRows = 0;
+
+    pendingGarbage = 0;
+    garbageSent = 0;
+}
+
+void Board::setRandomSeed(uint32_t seed) {
+    blockRandom.seed(seed);
+}
+
+void Board::spawnBlock() {
+    applyGarbage();
+
+    blockFalling.id = queue[0];
+    blockFalling.timer = 0;
+    blockFalling.pos.y = -2;
+    blockFalling.pos.x = gridWidth / 2 - blocks[blockFalling.id].width / 2;
+    blockFalling.rot = 0;
+
+    for(int i = 0; i < previewSize - 1; i++)
+        queue[i] = queue[i + 1];
+
+    queue[previewSize - 1] = nextBagBlock();
+}
+
+void Board::rotateBlock(int dir) {
+    int newRot = (blockFalling.rot + dir) % 4;
+    if(!blockHitRot(newRot)) {
+        blockFalling.rot = newRot;
+
+        pushAwayFromSide();
+    }
+}
+
+bool Board::moveBlock(int dir) {
+    if(blockHitMove(dir))
+        return false;
+
+    blockFalling.pos.x += dir;
+    return true;
+}
+
+bool Board::updateFalling(int fallTime) {
+    if(blockFalling.timer < fallTime) {
+        blockFalling.timer++;
+        return false;
+    }
+
+    if(!fallingBlockHit()) {
+        blockFalling.pos.y++;
+        blockFalling.timer = 0;
+        return false;
+    }
+
+    landBlock();
+    return true;
+}
+
+bool Board::dropBlock(int x, int rot) {
+    blockFalling.pos = Point(x, -2);
+    blockFalling.rot = rot;
+
+    if(blockHitRot(rot, true))
+        return false;
+
+    blockFalling.pos.y = getDropY();
+
+    landBlock();
+    return true;
+}
+
+bool Board::hardDrop() {
+    if(blockFalling.id == -1)
+        return false;
+
+    blockFalling.pos.y = getDropY();
+
+    landBlock();
+    return true;
+}
+
+int Board::getDropY() const {
+    auto &block = blocks[blockFalling.id];
+    int drop = gridHeight;
+
+    // distance from each tile to the top of its column
+    for(int y = 0; y < block.height; y++) {
+        for(int x = 0; x < block.width; x++) {
+            if(!block.hasTile(x, y))
+                continue;
+
+            Point rotPos = blockFalling.pos + rotateIt(Point(x, y), block.width, block.height, blockFalling.rot);
+            int top = gridHeight - columnHeights[rotPos.x];
+
+            // moved under an overhang, the top of the column isn't what it'll land on
+            if(rotPos.y >= top) {
+                int dropY = 0;
+                while(!fallingBlockHit(dropY))
+                    dropY++;
+
+                return blockFalling.pos.y + dropY;
+            }
+
+            drop = std::min(drop, top - 1 - rotPos.y);
+        }
+    }
+
+    return blockFalling.pos.y + drop;
+}
+
+bool Board::updateRowFalling(bool &rowLanded) {
+    bool isFalling = false;
+    rowLanded = false;
+
+    for(auto &row : rowFalling) {
+        if(row) {
+            row--;
+            isFalling = true;
+
+            // this should check if the row above is non-empty...
+            if(!row)
+                rowLanded = true;
+        }
+    }
+
+    return isFalling;
+}
+
+bool Board::checkLost() const {
+    return !isRowEmpty(grid, rowBytes);
+}
+
+void Board::saveSnapshot(BoardSnapshot &snapshot) const {
+    snapshot.version = BoardSnapshot::currentVersion;
+    snapshot.lines = lines;
+    snapshot.score = score;
+    snapshot.randomState = blockRandom.state;
+
+    snapshot.blockId = blockFalling.id;
+    snapshot.blockRot = blockFalling.rot;
+    snapshot.blockX = blockFalling.pos.x;
+    snapshot.blockY = blockFalling.pos.y;
+    snapshot.blockTimer = blockFalling.timer;
+    snapshot.bag = bag;
+    snapshot.combo = combo;
+    snapshot.lastWasTetris = lastWasTetris;
+
+    for(int i = 0; i < previewSize; i++)
+        snapshot.queue[i] = queue[i];
+
+    for(auto &b : snapshot.cells)
+        b = 0;
+
+    // cells can be 0-7, so 3 bits each, some straddle two bytes
+    for(int i = 0; i < gridWidth * gridHeight; i++) {
+        int bit = i * 3;
+        int shift = bit % 8;
+
+        int cell = (grid[i / 2] >> (i % 2) * 4) & 0xF;
+
+        snapshot.cells[bit / 8] |= cell << shift;
+
+        if(shift > 5)
+            snapshot.cells[bit / 8 + 1] |= cell >> (8 - shift);
+    }
+}
+
+bool Board::loadSnapshot(const BoardSnapshot &snapshot) {
+    if(snapshot.version != BoardSnapshot::currentVersion)
+        return false;
+
+    if(snapshot.blockId < -1 || snapshot.blockId >= numBlocks || snapshot.bag >= 1 << numBlocks)
+        return false;
+
+    for(auto &block : snapshot.queue) {
+        if(block >= numBlocks)
+            return false;
+    }
+
+    // the falling block has to be inside the grid (or above it) or placing it would write outside
+    if(snapshot.blockId != -1) {
+        if(snapshot.blockRot < 0 || snapshot.blockRot > 3)
+            return false;
+
+        auto &block = blocks[snapshot.blockId];
+        Point pos(snapshot.blockX, snapshot.blockY);
+
+        for(int y = 0; y < block.height; y++) {
+            for(int x = 0; x < block.width; x++) {
+                if(!block.hasTile(x, y))
+                    continue;
+
+                Point rotPos = pos + rotateIt(Point(x, y), block.width, block.height, snapshot.blockRot);
+
+                if(rotPos.x < 0 || rotPos.x >= gridWidth || rotPos.y >= gridHeight)
+                    return false;
+            }
+        }
+    }
+
+    for(auto &b : grid)
+        b = 0;
+
+    for(int i = 0; i < gridWidth * gridHeight; i++) {
+        int bit = i * 3;
+        int shift = bit % 8;
+
+        int cell = snapshot.cells[bit / 8] >> shift;
+
+        if(shift > 5)
+            cell |= snapshot.cells[bit / 8 + 1] << (8 - shift);
+
+        grid[i / 2] |= (cell & 7) << (i % 2) * 4;
+    }
+
+    blockFalling.id = snapshot.blockId;
+    blockFalling.rot = snapshot.blockRot;
+    blockFalling.pos = Point(snapshot.blockX, snapshot.blockY);
+    blockFalling.timer = snapshot.blockTimer;
+    bag = snapshot.bag;
+
+    for(int i = 0; i < previewSize; i++)
+        queue[i] = snapshot.queue[i];
+
+    lines = snapshot.lines;
+    score = snapshot.score;
+    combo = snapshot.combo;
+    lastWasTetris = snapshot.lastWasTetris;
+    setRandomSeed(snapshot.randomState);
+
+    for(auto &row : rowFalling)
+        row = 0;
+
+    updateColumnHeights();
+
+    numClearedRows = 0;
+
+    return true;
+}
+
+uint8_t Board::getCell(int x, int y) const {
+    return (grid[x / 2 + y * rowBytes] >> (x % 2) * 4) & 0xF;
+}
+
+RowMask Board::getRowMask(int y) const {
+    RowMask mask = 0;
+    auto row = grid + y * rowBytes;
+
+    for(int i = 0; i < rowBytes; i++) {
+        RowMask bits = (row[i] & 0x0F ? 1 : 0) | (row[i] & 0xF0 ? 2 : 0);
+        mask |= bits << i * 2;
+    }
+
+    return mask;
+}
+
+int Board::getColumnHeight(int x) const {
+    return columnHeights[x];
+}
+
+int Board::getRowFalling(int y) const {
+    return rowFalling[y];
+}
+
+const FallingBlock &Board::getFallingBlock() const {
+    return blockFalling;
+}
+
+int Board::getNextBlock(int i) const {
+    return queue[i];
+}
+
+int Board::getScore() const {
+    return score;
+}
+
+int Board::getLines() const {
+    return lines;
+}
+
+int Board::getCombo() const {
+    return combo;
+}
+
+int Board::getNumClearedRows() const {
+    return numClearedRows;
+}
+
+const Board::ClearedRow &Board::getClearedRow(int i) const {
+    return clearedRows[i];
+}
+
+void Board::addGarbage(int rows) {
+    pendingGarbage = std::min(pendingGarbage + rows, gridHeight);
+}
+
+int Board::getPendingGarbage() const {
+    return pendingGarbage;
+}
+
+int Board::getGarbageSent() const {
+    return garbageSent;
+}
+
+int Board::nextBagBlock() {
+    const int fullBag = (1 << numBlocks) - 1;
+
+    if(bag == fullBag)
+        bag = 0;
+
+    int left = 0;
+    for(int i = 0; i < numBlocks; i++) {
+        if(!(bag & (1 << i)))
+            left++;
+    }
+
+    // pick one of the blocks left in this bag
+    int pick = blockRandom.next() % left;
+
+    for(int i = 0; i < numBlocks; i++) {
+        if(bag & (1 << i))
+            continue;
+
+        if(pick-- == 0) {
+            bag |= 1 << i;
+            return i;
+        }
+    }
+
+    return 0;
+}
+
+int Board::calculateScore(int clearedLines) const {
+    
+    int addedScore = clearedLines * 10 + lines;
+
+    //"tetris"
+    if(clearedLines == 4)
+        addedScore *= lastWasTetris ? 3 : 2;
+
+    // bonus for combo (1.5 for 2 in a row, 2.25 for 3, ...)
+    addedScore = addedScore * std::pow(1.5f, combo);
+
+    return addedScore;
+}
+
+void Board::checkLine() {
+    numClearedRows = 0;
+    garbageSent = 0;
+
+    //most lines possible at once = 4
+    for(int l = 0; l < 4; l++) {
+
+        int clearedLines = 0;
+        int found = 0;
+
+        for(int y = gridHeight - 1; y >= 0; y--) {
+            bool isLine = isRowFull(grid + y * rowBytes, rowBytes);
+
+            // this line is not complete and a previous one was, we're done
+            if(found && !isLine)
+                break;
+
+            // track y of first line
+            if(isLine && found == 0)
+                found = y;
+
+            if(found != 0)
+                clearedLines++;
+        }
+
+        // stop if there are no more full lines
+        if(clearedLines == 0) {
+            // reset combo if this was the first try
+            if(l == 0)
+                combo = 0;
+            else { // otherwise we got at least one, so increment
+                combo++;
+                updateColumnHeights();
+            }
+
+            // cancel out our own garbage first
+            int sent = garbageForLines[numClearedRows];
+            int cancelled = std::min(sent, int(pendingGarbage));
+            pendingGarbage -= cancelled;
+            garbageSent = sent - cancelled;
+            return;
+        }
+
+        int addedScore = calculateScore(clearedLines);
+
+        lastWasTetris = clearedLines == 4;
+
+        // keep the cleared rows around for effects
+        for(int y = found; y > found - clearedLines; y--) {
+            if(numClearedRows == 4)
+                break;
+
+            auto &row = clearedRows[numClearedRows++];
+            row.y = y;
+            for(int x = 0; x < gridWidth; x++)
+                row.cells[x] = getCell(x, y);
+        }
+
+        //move down
+        for(int y = found; y >= 0; y--) {
+            int newY = y + clearedLines;
+            if(newY > found)
+                continue;
+
+            memcpy(grid + newY * rowBytes, grid + y * rowBytes, rowBytes);
+
+            rowFalling[newY] += rowFallTime * clearedLines;
+        }
+
+        //fill top
+        memset(grid, 0, clearedLines * rowBytes);
+
+        score += addedScore;
+        lines += clearedLines;
+    }
+}
+
+void Board::placeBlock() {
+    auto &block = blocks[blockFalling.id];
+
+    for(int y = 0; y < block.height; y++) {
+        for(int x = 0; x < block.width; x++) {
+            Point rotPos = blockFalling.pos + rotateIt(Point(x, y), block.width, block.height, blockFalling.rot);
+
+            if(block.hasTile(x, y) && rotPos.y >= 0) {
+                setCell(rotPos.x, rotPos.y, blockFalling.id + 1);
+
+                columnHeights[rotPos.x] = std::max(int(columnHeights[rotPos.x]), gridHeight - rotPos.y);
+            }
+        }
+    }
+}
+
+void Board::landBlock() {
+    placeBlock();
+
+    checkLine();
+
+    blockFalling.id = -1;
+}
+
+// after rows have moved, just rescan
+void Board::updateColumnHeights() {
+    RowMask found = 0;
+
+    for(auto &height : columnHeights)
+        height = 0;
+
+    for(int y = 0; y < gridHeight && found != fullRowMask; y++) {
+        RowMask newCells = getRowMask(y) & ~found;
+        found |= newCells;
+
+        for(int x = 0; x < gridWidth; x++) {
+            if(newCells & (RowMask(1) << x))
+                columnHeights[x] = gridHeight - y;
+        }
+    }
+}
+
+void Board::setCell(int x, int y, uint8_t value) {
+    auto &b = grid[x / 2 + y * rowBytes];
+    int shift = (x % 2) * 4;
+    b = (b & ~(0xF << shift)) | value << shift;
+}
+
+// pushes the grid up and fills the bottom with rows that have one gap
+void Board::applyGarbage() {
+    int rows = pendingGarbage;
+    pendingGarbage = 0;
+
+    if(!rows)
+        return;
+
+    // anything pushed off the top is lost, but the hidden row will be full by then
+    memmove(grid, grid + rows * rowBytes, (gridHeight - rows) * rowBytes);
+
+    for(int y = gridHeight - rows; y < gridHeight; y++) {
+        int gap = blockRandom.next() % gridWidth;
+        int cell = blockRandom.next() % numBlocks + 1;
+
+        for(int x = 0; x < gridWidth; x++)
+            setCell(x, y, x == gap ? 0 : cell);
+    }
+
+    updateColumnHeights();
+}
+
+// checks if block can be moved
+bool Board::blockHitMove(int move) const {
+    auto &block = blocks[blockFalling.id];
+
+    for(int y = 0; y < block.height; y++) {
+        for(int x = 0; x < block.width; x++) {
+            Point rotPos = blockFalling.pos + rotateIt(Point(x, y), block.width, block.height, blockFalling.rot);
+
+            if(!block.hasTile(x, y))
+                continue;
+
+            //side, even above the top so the block can't leave the grid before it's visible
+            if(rotPos.x + move >= gridWidth)
+                return true;
+
+            if(rotPos.x + move < 0)
+                return true;
+
+            if(rotPos.y < 0)
+                continue;
+
+            //block block beside
+            if(getCell(rotPos.x + move, rotPos.y) != 0)
+                return true;
+        }
+    }
+
+    return false;
+}
+
+// checks if falling block has hit something, or would if it was dropY further down
+bool Board::fallingBlockHit(int dropY) const {
+    auto &block = blocks[blockFalling.id];
+
+    for(int y = 0; y < block.height; y++) {
+        for(int x = 0; x < block.width; x++) {
+            Point rotPos = blockFalling.pos + rotateIt(Point(x, y), block.width, block.height, blockFalling.rot);
+            rotPos.y += dropY;
+
+            if(rotPos.y < 0)
+                continue;
+
+            if(block.hasTile(x, y)) {
+                //bottom
+                if(rotPos.y >= gridHeight - 1)
+                    return true;
+
+                //block under
+                if(rotPos.y + 1 < gridHeight) {
+                    if(getCell(rotPos.x, rotPos.y + 1) != 0)
+                        return true;
+                }
+
+            }
+        }
+    }
+
+    return false;
+}
+
+// checks if rotating the falling block would hit something
+bool Board::blockHitRot(int newRot, bool checkXBounds) const {
+    auto &block = blocks[blockFalling.id];
+
+    for(int y = 0; y < block.height; y++) {
+        for(int x = 0; x < block.width; x++) {
+            Point rotPos = blockFalling.pos + rotateIt(Point(x, y), block.width, block.height, newRot);
+
+            if(!block.hasTile(x, y))
+                continue;
+
+            // checked above the top too
+            if(rotPos.x < 0 || rotPos.x >= gridWidth) {
+                if(checkXBounds)
+                    return true;
+                
+                // player input can ignore x bounds, it's adjusted later
+                continue;
+            }
+
+            if(rotPos.y < 0)
+                continue;
+
+            // rotated through the floor
+            if(rotPos.y >= gridHeight)
+                return true;
+
+            //inside block
+            if(getCell(rotPos.x, rotPos.y) != 0)
+                return true;
+        }
+    }
+
+    return false;
+}
+
+// pushes block back into bounds after rotation
+void Board::pushAwayFromSide() {
+    auto &block = blocks[blockFalling.id];
+
+    for(int y = 0; y < block.height; y++) {
+        for(int x = 0; x < block.width; x++) {
+            Point rotPos = blockFalling.pos + rotateIt(Point(x, y), block.width, block.height, blockFalling.rot);
+
+            //inside wall, including tiles above the top
+            if(block.hasTile(x, y)) {
+                if(rotPos.x >= gridWidth)
+                    blockFalling.pos.x--;
+                else if(rotPos.x < 0)
+                    blockFalling.pos.x++;
+            }
+        }
+    }
+}
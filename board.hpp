@@ -0,0 +1,164 @@
+#pragma once
+#include <cstdint>
+
+#include "types/point.hpp"
+
+#include "blocks.hpp"
+#include "xorshift.hpp"
+
+// blocks shown after the falling one
+static const int previewSize = 4;
+
+struct FallingBlock {
+    blit::Point pos;
+    int8_t id = -1;
+    uint8_t rot = 0;
+    uint8_t timer = 0;
+};
+
+// everything needed to continue a game, packed small enough to save often and copy cheaply
+struct BoardSnapshot {
+    static const uint16_t currentVersion = 2;
+
+    uint16_t version = 0; // 0 = no game
+    uint16_t lines = 0;
+    uint32_t score = 0;
+    uint32_t randomState = 0;
+
+    int8_t blockId = -1;
+    int8_t blockRot = 0;
+    int8_t blockX = 0, blockY = 0;
+    uint8_t blockTimer = 0;
+    uint8_t bag = 0;
+    uint8_t combo = 0;
+    uint8_t lastWasTetris = 0;
+    uint8_t queue[previewSize]{0};
+
+    // 3 bits per cell, rounded up to a whole word
+    static const int cellBytes = (gridWidth * gridHeight * 3 + 31) / 32 * 4;
+    uint8_t cells[cellBytes]{0};
+};
+
+static_assert(sizeof(BoardSnapshot) == 20 + previewSize + BoardSnapshot::cellBytes, "BoardSnapshot should not have padding");
+
+// grid, falling block and scoring for one game
+// doesn't touch the screen, input or global random so it can be used headless
+class Board final {
+public:
+    static const int rowFallTime = 16; // how many ticks it takes for a row to fall one block
+
+    struct ClearedRow {
+        int8_t y;
+        uint8_t cells[gridWidth];
+    };
+
+    void reset(uint32_t seed);
+
+    // changes the blocks that come after the preview, used to try out different futures
+    void setRandomSeed(uint32_t seed);
+
+    // moves the next block to the top and adds one to the end of the preview, adding any garbage rows first
+    void spawnBlock();
+
+    void rotateBlock(int dir);
+    bool moveBlock(int dir);
+
+    // moves the falling block down every fallTime ticks, returns true if it landed
+    bool updateFalling(int fallTime);
+
+    // drops the block straight down at x with the given rotation, for auto-play
+    bool dropBlock(int x, int rot);
+
+    // drops the falling block to where it would land and places it
+    bool hardDrop();
+
+    // y the falling block would land at if dropped straight down
+    int getDropY() const;
+
+    // scrolls down rows after clearing lines, returns true if any are still falling
+    bool updateRowFalling(bool &rowLanded);
+
+    bool checkLost() const;
+
+    void saveSnapshot(BoardSnapshot &snapshot) const;
+    // doesn't restore any animations, returns false if the snapshot is invalid
+    bool loadSnapshot(const BoardSnapshot &snapshot);
+
+    uint8_t getCell(int x, int y) const;
+    // bit x is set if the cell is filled
+    RowMask getRowMask(int y) const;
+    // rows from the bottom to the highest filled cell
+    int getColumnHeight(int x) const;
+    int getRowFalling(int y) const;
+
+    const FallingBlock &getFallingBlock() const;
+    // 0 is the next block to spawn, up to previewSize - 1
+    int getNextBlock(int i = 0) const;
+
+    int getScore() const;
+    int getLines() const;
+    int getCombo() const;
+
+    // lines cleared by the last block to land
+    int getNumClearedRows() const;
+    const ClearedRow &getClearedRow(int i) const;
+
+    // versus, rows to push up from the bottom before the next block
+    void addGarbage(int rows);
+    int getPendingGarbage() const;
+    // rows to send to the other board for the last block to land (after cancelling any pending)
+    int getGarbageSent() const;
+
+private:
+    // shuffled bags of all seven
+    int nextBagBlock();
+
+    int calculateScore(int clearedLines) const;
+    void checkLine();
+    void placeBlock();
+    void landBlock();
+    void updateColumnHeights();
+
+    void setCell(int x, int y, uint8_t value);
+    void applyGarbage();
+
+    bool blockHitMove(int move) const;
+    bool fallingBlockHit(int dropY = 0) const;
+    bool blockHitRot(int newRot, bool checkXBounds = false) const;
+    void pushAwayFromSide();
+
+    // two cells per byte, low nibble first
+    static const int rowBytes = gridWidth / 2;
+    uint8_t grid[rowBytes * gridHeight]{0};
+
+    FallingBlock blockFalling;
+
+    // blocks and garbage, nothing else uses this
+    XorShift32 blockRandom;
+
+    int score = 0;
+    int lines = 0;
+    int combo = 0;
+    bool lastWasTetris = false;
+
+    int8_t queue[previewSize]{0};
+    uint8_t bag = 0; // bit set for each block already taken from the current bag
+
+    // kept up to date when blocks are placed or rows move
+    uint8_t columnHeights[gridWidth]{0};
+
+    uint8_t rowFalling[gridHeight]{0};
+
+    ClearedRow clearedRows[4];
+    uint8_t numClearedRows = 0;
+
+    uint8_t pendingGarbage = 0;
+    uint8_t garbageSent = 0;
+};
+
+static_assert(gridWidth % 2 == 0, "rows should start on a byte boundary");
+static_assert(Board::rowFallTime * 4 <= 255, "rowFalling can't hold a four line clear");
+static_assert(numBlocks <= 8, "bag is a byte");
+
+// see tools/ram-report.cpp for the full breakdown, only applies to the size the game uses
+static_assert(gridWidth != 10 || gridHeight != 16 || sizeof(Board) <= 192, "Board is over its RAM budget");
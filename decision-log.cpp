@@ -0,0 +1,120 @@
+#include <cstring>
+
+#include "board.hpp"
+#include "decision-log.hpp"
+
+void beginDecision(DecisionRecord &record, const Board &board, uint32_t game, int piece) {
+    for(int y = 0; y < gridHeight; y++)
+        record.rows[y] = board.getRowMask(y);
+
+    auto &block = board.getFallingBlock();
+
+    record.game = game;
+    record.piece = piece;
+    record.blockId = block.id;
+    record.nextBlock = board.getNextBlock();
+
+    // score before, replaced with the difference when done
+    record.scoreDelta = board.getScore();
+}
+
+void endDecision(DecisionRecord &record, const Board &board) {
+    // still has the last position after landing
+    auto &block = board.getFallingBlock();
+
+    record.x = block.pos.x;
+    record.rot = block.rot;
+    record.y = block.pos.y;
+    record.linesCleared = board.getNumClearedRows();
+    record.scoreDelta = board.getScore() - record.scoreDelta;
+}
+
+DecisionWriter::~DecisionWriter() {
+    close();
+}
+
+bool DecisionWriter::open(const char *path) {
+    close();
+
+    DecisionFileHeader header;
+    header.recordSize = sizeof(DecisionRecord);
+
+    long size = 0;
+
+    // check we're appending the same kind of records
+    if(auto existing = fopen(path, "rb")) {
+        DecisionFileHeader existingHeader;
+        bool valid = fread(&existingHeader, sizeof(existingHeader), 1, existing) == 1
+                  && memcmp(&existingHeader, &header, sizeof(header)) == 0;
+
+        fseek(existing, 0, SEEK_END);
+        size = ftell(existing);
+        fclose(existing);
+
+        // also reject a partly written record
+        if(size && (!valid || (size - sizeof(header)) % sizeof(DecisionRecord)))
+            return false;
+    }
+
+    file = fopen(path, "ab");
+    if(!file)
+        return false;
+
+    // already buffering
+    setvbuf(file, nullptr, _IONBF, 0);
+
+    if(size == 0 && fwrite(&header, sizeof(header), 1, file) != 1) {
+        close();
+        return false;
+    }
+
+    numRecords = size ? (size - sizeof(header)) / sizeof(DecisionRecord) : 0;
+
+    return true;
+}
+
+void DecisionWriter::close() {
+    if(!file)
+        return;
+
+    flush();
+    fclose(file);
+    file = nullptr;
+}
+
+bool DecisionWriter::isOpen() const {
+    return file != nullptr;
+}
+
+void DecisionWriter::write(const DecisionRecord &record) {
+    buffer[buffered++] = record;
+    numRecords++;
+
+    if(buffered == bufferRecords)
+        flush();
+}
+
+void DecisionWriter::write(const DecisionRecord *records, int count) {
+    // big enough to skip the buffer
+    if(count >= bufferRecords) {
+        flush();
+        fwrite(records, sizeof(DecisionRecord), count, file);
+        numRecords += count;
+        return;
+    }
+
+    for(int i = 0; i < count; i++)
+        write(records[i]);
+}
+
+void DecisionWriter::flush() {
+    if(!buffered)
+        return;
+
+    fwrite(buffer, sizeof(DecisionRecord), buffered, file);
+    buffered = 0;
+}
+
+uint64_t DecisionWriter::getNumRecords() const {
+    return numRecords;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+
+#include "blocks.hpp"
+
+class Board;
+
+// file is a DecisionFileHeader followed by DecisionRecords, all little-endian
+// records are fixed size so the file can be mapped and indexed directly
+struct DecisionFileHeader {
+    static const uint16_t currentVersion = 1;
+
+    char magic[4]{'F', 'B', 'D', 'L'};
+    uint16_t version = currentVersion;
+    uint16_t recordSize;
+    uint8_t gridWidth = ::gridWidth;
+    uint8_t gridHeight = ::gridHeight;
+    uint8_t reserved[6]{0};
+};
+
+// one block placement
+struct DecisionRecord {
+    RowMask rows[gridHeight];  // board before the block, bit x of rows[y] is set if filled
+    uint32_t game;             // records in the file before the game's first one, unique across sessions
+    int32_t scoreDelta;
+    uint16_t piece;            // blocks placed before this one in the game
+    int8_t blockId;
+    int8_t nextBlock;
+    int8_t x, rot, y;          // where it landed
+    uint8_t linesCleared;
+};
+
+static_assert(sizeof(DecisionFileHeader) == 16, "DecisionFileHeader should not have padding");
+static_assert(sizeof(DecisionRecord) == gridHeight * sizeof(RowMask) + 16, "DecisionRecord should not have padding");
+
+// fills in the board and blocks, call after spawning the block
+void beginDecision(DecisionRecord &record, const Board &board, uint32_t game, int piece);
+// fills in where the block landed and what it scored, call after it lands
+void endDecision(DecisionRecord &record, const Board &board);
+
+// appends records to a file, buffered so writing one is just a copy
+class DecisionWriter final {
+public:
+    ~DecisionWriter();
+
+    // appends if the file already exists, fails if it has a different header
+    bool open(const char *path);
+    void close();
+
+    bool isOpen() const;
+
+    void write(const DecisionRecord &record);
+    void write(const DecisionRecord *records, int count);
+    void flush();
+
+    // including any still buffered
+    uint64_t getNumRecords() const;
+
+private:
+    static const int bufferRecords = 1024;
+
+    FILE *file = nullptr;
+
+    DecisionRecord buffer[bufferRecords];
+    int buffered = 0;
+
+    uint64_t numRecords = 0;
+};
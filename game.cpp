@@ -1,120 +1,75 @@
-#include <list>
-
 #include "game.hpp"
 #include "assets.hpp"
+#include "blocks.hpp"
+#include "board.hpp"
+#include "player.hpp"
+#ifdef ROLLOUT_PLANNER
+#include "planner.hpp"
+#endif
+#if defined(DECISION_LOG) || defined(TELEMETRY_CSV)
+#include <cstdlib>
+#endif
+#ifdef DECISION_LOG
+#include "decision-log.hpp"
+#endif
 #include "leaderboard.hpp"
 #include "name-entry.hpp"
+#include "telemetry.hpp"
+#include "versus.hpp"
 
 using namespace blit;
 
 static const Font font(asset_font8x8);
 
-static const int gridWidth = 10, gridHeight = 16;
-static uint8_t grid[gridWidth * gridHeight]{0};
-
 static const int blockSize = 8;
 
-static const int fallTime = 30;
-static const int rowFallScale = 2; // how many ticks it takes for a row to fall one pixel
-
-struct Block {
-    bool pattern[2][4];
-    int width = 0, height = 0;
-};
-
-static Block blocks[]{
-    //Z
-    {
-        {
-            {true, true, false},
-            {false, true, true}
-        },
-        3, 2
-    },
-    //L
-    {
-        {
-            {false, false, true},
-            {true, true, true}
-        },
-        3, 2
-    },
-    //O
-    {
-        {
-            {true, true},
-            {true, true}
-        },
-        2, 2
-    },
-    //S
-    {
-        {
-            {false, true, true},
-            {true, true, false}
-        },
-        3, 2
-    },
-    //I
-    {
-        {
-            {false, false, false, false},
-            {true, true, true, true}
-        },
-        4, 2
-    },
-    //J
-    {
-        {
-            {true},
-            {true, true, true}
-        },
-        3, 2
-    },
-    //T
-    {
-        {
-            {false, true},
-            {true, true, true}
-        },
-        3, 2
-    }
-};
-
-static struct {
-    Point pos;
-    int id = -1;
-    int rot = 0;
-    int timer = 0;
-
-} blockFalling;
+// players[0] is the main game, the rest are only used by the spectator wall
+static const int maxPlayers = Player::maxPlayers;
+static Player players[maxPlayers];
+static Player &mainPlayer = players[0];
+static Board &board = mainPlayer.getBoard();
 
-static int nextBlock = 0;
-
-static int move = 0, rotate = 0;
-
-static int score = 0;
-static int lines = 0;
-static int combo = 0;
-static bool lastWasTetris = false;
+static const int snapshotSaveSlot = 1;
+// saving blocks, so only every few blocks (and on pause/game over)
+static const int snapshotSaveInterval = 10;
+static int blocksSinceSave = 0;
 
 static bool gameStarted = false, gameEnded = false, gamePaused = false;
 
-static int rowFalling[gridHeight]{0};
+// lots of auto-play boards at once
+static bool wallMode = false;
+static int wallBoards = maxPlayers;
 
-struct BlockParticle {
-    Vec2 vel;
-    Vec2 pos;
-    int sprite = 0;
-};
+static Versus versus(font);
+static bool versusMode = false;
 
-static std::list<BlockParticle> particles;
+#ifdef ROLLOUT_PLANNER
+// slower, stronger bot that runs on a thread pool
+static RolloutPlanner planner;
+static bool usePlanner = false;
+#endif
+
+#ifdef DECISION_LOG
+// set FOURBLOCK_DECISIONS to a file to record the player's placements (auto-play isn't recorded)
+static DecisionWriter decisionLog;
+#endif
 
 static Leaderboard leaderboard(font);
 static bool showLeaderboard = true;
 static NameEntry nameEntry(font);
 static bool needNameEntry = false;
 
+// stats for the last few games, set FOURBLOCK_TELEMETRY to a file to also write them as CSV
+static Telemetry telemetry;
+
+// see tools/ram-report.cpp for the breakdown, particles are on the heap on top of this
+static_assert(sizeof(players) + sizeof(Versus) + sizeof(Telemetry) <= 6 * 1024, "game state is over its RAM budget");
+
+// nothing moves while paused or after losing, so those screens are only
+// redrawn after input and update does nothing in between
+static bool screenDirty = true;
+static uint32_t lastButtons = 0;
+
 // sound
 static const int noiseChannel = 0;
 
@@ -123,291 +78,204 @@ void playDropSound(int vol = 0x3FFF) {
     channels[noiseChannel].trigger_attack();
 }
 
-static Point rotateIt(Point pos, int w, int h, int rot) {
-    // doubling everthing for precision
-    int center = (std::max(w, h) - 1);
-
-    int rX = pos.x * 2 - center;
-    int rY = pos.y * 2 - center;
-
-    if(rot == 1) {
-        int tmp = rX;
-        rX = -rY;
-        rY = tmp;
-    } else if(rot == 2) {
-        rX = -rX;
-        rY = -rY;
-    } else if(rot == 3) {
-        int tmp = rX;
-        rX = rY;
-        rY = -tmp;
-    }
+// keeps the game in progress so it can be continued if the power goes off
+static void saveGame() {
+    blocksSinceSave = 0;
 
-    return Point((rX + center) / 2, (rY + center) / 2);
-}
+    BoardSnapshot snapshot;
 
-static int calculateScore(int clearedLines) {
-    
-    int addedScore = clearedLines * 10 + lines;
+    // an empty snapshot clears it
+    if(gameStarted && !gameEnded)
+        board.saveSnapshot(snapshot);
 
-    //"tetris"
-    if(clearedLines == 4)
-        addedScore *= lastWasTetris ? 3 : 2;
+    write_save(snapshot, snapshotSaveSlot);
 
-    // bonus for combo (1.5 for 2 in a row, 2.25 for 3, ...)
-    addedScore = addedScore * std::pow(1.5f, combo);
-
-    return addedScore;
+#ifdef DECISION_LOG
+    if(decisionLog.isOpen())
+        decisionLog.flush();
+#endif
 }
 
-static void checkLine() {
-    //most lines possible at once = 4
-    for(int l = 0; l < 4; l++) {
-
-        int clearedLines = 0;
-        int found = 0;
-
-        for(int y = gridHeight - 1; y >= 0; y--) {
-            int isLine = true;
-            for(int x = 0; x < gridWidth; x++) {
-                if(grid[x + y * gridWidth] == 0) {
-                    isLine = false;
-                    break;
-                }
-            }
-
-            // this line is not complete and a previous one was, we're done
-            if(found && !isLine)
-                break;
-
-            // track y of first line
-            if(isLine && found == 0)
-                found = y;
-
-            if(found != 0)
-                clearedLines++;
-        }
-
-        // stop if there are no more full lines
-        if(clearedLines == 0) {
-            // reset combo if this was the first try
-            if(l == 0)
-                combo = 0;
-            else // otherwise we got at least one, so increment
-                combo++;
-            return;
-        }
-
-        int addedScore = calculateScore(clearedLines);
-
-        lastWasTetris = clearedLines == 4;
-
-        // particles!
-        for(int y = found; y > found - clearedLines; y--) {
-            for(int x = 0; x < gridWidth; x++) {
-                BlockParticle b;
-                b.pos = Vec2(x * blockSize, (y - 1) * blockSize);
-                b.vel.x = (blit::random() / static_cast<float>(0xFFFFFFFF)) * 2.0f - 1.0f;
-                b.vel.y = (blit::random() / static_cast<float>(0xFFFFFFFF)) * -1.0f;
-                b.sprite = grid[x + y * gridWidth] - 1;
-                particles.push_back(b);
-            }
-        }
+static void saveTelemetry() {
+    telemetry.save();
 
-        //move down
-        for(int y = found; y >= 0; y--) {
-            int newY = y + clearedLines;
-            if(newY > found)
-                continue;
-
-            for(int x = 0; x < gridWidth; x++) {
-                grid[x + newY * gridWidth] = grid[x + y * gridWidth];
-            }
-
-            rowFalling[newY] += blockSize * clearedLines * rowFallScale;
-        }
+#ifdef TELEMETRY_CSV
+    if(auto path = getenv("FOURBLOCK_TELEMETRY"))
+        telemetry.exportCSV(path);
+#endif
+}
 
-        //fill top
-        for(int i = 0; i < clearedLines; i++) {
-            for(int x = 0; x < gridWidth; x++) {
-                grid[x + i * gridWidth] = 0;
-            }
-        }
+static void reset() {
+    gameEnded = false;
+    gameStarted = true;
 
-        score += addedScore;
-        lines += clearedLines;
-    }
+    mainPlayer.reset(blit::random());
+    mainPlayer.setAutoPlay(false);
 }
 
-static void placeBlock() {
-    auto &block = blocks[blockFalling.id];
+// auto-play until started
+static void resetAutoPlay() {
+    mainPlayer.reset(blit::random());
+    mainPlayer.setAutoPlay(true);
+    gameStarted = false;
+}
 
-    for(int y = 0; y < block.height; y++) {
-        for(int x = 0; x < block.width; x++) {
-            Point rotPos = blockFalling.pos + rotateIt(Point(x, y), block.width, block.height, blockFalling.rot);
+static void startWall() {
+    set_screen_mode(ScreenMode::hires);
+    wallMode = true;
 
-            if(block.pattern[y][x] && rotPos.y >= 0) {
-                grid[rotPos.x + rotPos.y * gridWidth] = blockFalling.id + 1;
-            }
-        }
+    for(auto &player : players) {
+        player.reset(blit::random());
+        player.setAutoPlay(true);
+#ifdef ROLLOUT_PLANNER
+        player.setPlanner(nullptr);
+#endif
     }
 }
 
-// checks if block can be moved
-static bool blockHitMove(int move) {
-    auto &block = blocks[blockFalling.id];
+static void endWall() {
+    set_screen_mode(ScreenMode::lores);
+    wallMode = false;
 
-    for(int y = 0; y < block.height; y++) {
-        for(int x = 0; x < block.width; x++) {
-            Point rotPos = blockFalling.pos + rotateIt(Point(x, y), block.width, block.height, blockFalling.rot);
+    resetAutoPlay();
+#ifdef ROLLOUT_PLANNER
+    mainPlayer.setPlanner(usePlanner ? &planner : nullptr);
+#endif
+}
 
-            if(rotPos.y < 0)
-                continue;
+static void updateWall() {
+    if(buttons.released & (Button::B | Button::MENU)) {
+        endWall();
+        return;
+    }
 
-            if(block.pattern[y][x]) {
-                //side
-                if(rotPos.x + move >= gridWidth)
-                    return true;
+    if((buttons.released & Button::DPAD_UP) && wallBoards < maxPlayers)
+        wallBoards++;
+    else if((buttons.released & Button::DPAD_DOWN) && wallBoards > 1)
+        wallBoards--;
 
-                if(rotPos.x + move < 0)
-                    return true;
+    for(int i = 0; i < wallBoards; i++) {
+        auto &player = players[i];
 
-                //block block beside
-                if(rotPos.x + move < gridWidth) {
-                    if(grid[rotPos.x + move + rotPos.y * gridWidth] != 0)
-                        return true;
-                }
-            }
-        }
+        // start again when lost, these games aren't recorded as they'd crowd out the main board's
+        if(player.getBoard().checkLost())
+            player.reset(blit::random());
+        else
+            player.update(PlayerInput());
     }
-
-    return false;
 }
 
-// checks if falling block has hit something
-static bool fallingBlockHit() {
-    auto &block = blocks[blockFalling.id];
+static void renderWall() {
+    screen.pen = Pen(0, 0, 0);
+    screen.clear();
 
-    for(int y = 0; y < block.height; y++) {
-        for(int x = 0; x < block.width; x++) {
-            Point rotPos = blockFalling.pos + rotateIt(Point(x, y), block.width, block.height, blockFalling.rot);
+    // up to four across, as big as will fit with room for the score below
+    int cols = std::min(wallBoards, 4);
+    int rows = (wallBoards + cols - 1) / cols;
+    int cellW = screen.bounds.w / cols;
+    int cellH = screen.bounds.h / rows;
+    int scoreH = font.char_h + 2;
 
-            if(rotPos.y < 0)
-                continue;
+    int size = std::min(cellW / gridWidth, (cellH - scoreH) / (gridHeight - 1));
+    size = std::max(size, 1);
 
-            if(block.pattern[y][x] != 0) {
-                //bottom
-                if(rotPos.y >= gridHeight - 1)
-                    return true;
+    int boardW = gridWidth * size, boardH = (gridHeight - 1) * size;
 
-                //block under
-                if(rotPos.y + 1 < gridHeight) {
-                    if(grid[rotPos.x + (rotPos.y + 1) * gridWidth] != 0)
-                        return true;
-                }
+    for(int i = 0; i < wallBoards; i++) {
+        Point cell((i % cols) * cellW, (i / cols) * cellH);
+        Point origin = cell + Point((cellW - boardW) / 2, (cellH - scoreH - boardH) / 2);
 
-            }
-        }
-    }
+        // keep particles inside the board
+        screen.clip = Rect(origin.x, origin.y, boardW, boardH);
+        players[i].render(origin, size);
+        screen.clip = Rect(Point(0, 0), screen.bounds);
 
-    return false;
+        screen.pen = Pen(0xFF, 0xFF, 0xFF);
+        screen.text(std::to_string(players[i].getBoard().getLines()), font, Rect(origin.x, origin.y + boardH + 2, boardW, font.char_h), true, TextAlign::top_center);
+    }
 }
 
-// checks if rotating the falling block would hit something
-static bool blockHitRot(int newRot, bool checkXBounds = false) {
-    auto &block = blocks[blockFalling.id];
+static void startVersus() {
+    set_screen_mode(ScreenMode::hires);
+    versusMode = true;
 
-    for(int y = 0; y < block.height; y++) {
-        for(int x = 0; x < block.width; x++) {
-            Point rotPos = blockFalling.pos + rotateIt(Point(x, y), block.width, block.height, newRot);
+    versus.start(true);
+}
 
-            if(rotPos.y < 0)
-                continue;
+static void endVersus() {
+    set_screen_mode(ScreenMode::lores);
+    versusMode = false;
 
-            // rotated through the floor
-            if(rotPos.y >= gridHeight)
-                return true;
+    resetAutoPlay();
+}
 
-            if(rotPos.x < 0 || rotPos.x >= gridWidth) {
-                if(checkXBounds)
-                    return true;
-                
-                // player input can ignore x bounds, it's adjusted later
-                continue;
-            }
+// loading that can wait until the title screen is up, one step per update
+enum class StartupStep {
+    ResumeGame,
+    LoadSaves,
+    SetupAudio,
+    Done
+};
 
-            //inside block
-            if(block.pattern[y][x]) {
-                if(grid[rotPos.x + rotPos.y * gridWidth] != 0)
-                    return true;
+static StartupStep startupStep = StartupStep::ResumeGame;
+static uint32_t startTime = 0, initTime = 0, firstFrameTime = 0;
+
+static void continueStartup() {
+    switch(startupStep) {
+        case StartupStep::ResumeGame: {
+            // continue the last game, paused
+            BoardSnapshot snapshot;
+            if(read_save(snapshot, snapshotSaveSlot) && mainPlayer.loadSnapshot(snapshot)) {
+                gameStarted = true;
+                gamePaused = true;
+                mainPlayer.setAutoPlay(false);
             }
+            break;
         }
-    }
 
-    return false;
-}
+        case StartupStep::LoadSaves:
+            leaderboard.load();
+            nameEntry.loadLastName();
+            telemetry.load();
 
-// pushes block back into bounds after rotation
-static void pushAwayFromSide() {
-    auto &block = blocks[blockFalling.id];
+#ifdef DECISION_LOG
+            if(auto path = getenv("FOURBLOCK_DECISIONS")) {
+                if(decisionLog.open(path))
+                    mainPlayer.setDecisionLog(&decisionLog);
+            }
+#endif
+            break;
 
-    for(int y = 0; y < block.height; y++) {
-        for(int x = 0; x < block.width; x++) {
-            Point rotPos = blockFalling.pos + rotateIt(Point(x, y), block.width, block.height, blockFalling.rot);
+        case StartupStep::SetupAudio:
+            channels[noiseChannel].waveforms = Waveform::NOISE;
+            channels[noiseChannel].frequency = 2000;
+            channels[noiseChannel].attack_ms = 5;
+            channels[noiseChannel].decay_ms = 150;
+            channels[noiseChannel].sustain = 0;
 
-            if(rotPos.y < 0)
-                continue;
+            debugf("startup: init %uus, first frame %uus, ready %uus\n", unsigned(initTime), unsigned(firstFrameTime), unsigned(us_diff(startTime, now_us())));
+            break;
 
-            //inside wall
-            if(block.pattern[y][x] != 0) {
-                if(rotPos.x >= gridWidth)
-                    blockFalling.pos.x--;
-                else if(rotPos.x < 0)
-                    blockFalling.pos.x++;
-            }
-        }
+        case StartupStep::Done:
+            return;
     }
-}
 
-static bool checkLost() {
-    for(int x = 0; x < gridWidth; x++) {
-        if(grid[x] != 0)
-            return true;
-    }
-    return false;
+    startupStep = StartupStep(int(startupStep) + 1);
 }
 
-static void reset() {
-    gameEnded = false;
-    gameStarted = true;
-    score = 0;
-    lines = 0;
-    lastWasTetris = false;
-
-    blockFalling.id = -1;
-
-    // clear grid and generate particles
-    for(int y = 0; y < gridHeight; y++) {
-        for(int x = 0; x < gridWidth; x++) {
-            if(grid[x + y * gridWidth] != 0) {
-                BlockParticle b;
-                b.pos = Vec2(x * blockSize, (y - 1) * blockSize);
-                b.vel.x = (blit::random() / static_cast<float>(0xFFFFFFFF)) * 2.0f - 1.0f;
-                b.vel.y = (blit::random() / static_cast<float>(0xFFFFFFFF)) * -1.0f;
-                b.sprite = grid[x + y * gridWidth] - 1;
-                particles.push_back(b);
-
-                grid[x + y * gridWidth] = 0;
-            }
-        }
-    }
+static bool isScreenStatic() {
+    return !wallMode && !versusMode && gameStarted && (gamePaused || gameEnded);
 }
 
 void init() {
+    startTime = now_us();
+
     set_screen_mode(ScreenMode::lores);
 
-    leaderboard.load();
-    nameEntry.loadLastName();
+    // stored unpacked as palette indices, so it's used in place instead of being decoded into RAM
+    screen.sprites = Surface::load_read_only(asset_tetris_sprites);
+
+    resetAutoPlay();
 
     int padding = 2;
     Rect leaderboardRect;
@@ -423,52 +291,38 @@ void init() {
     leaderboard.setDisplayRect(leaderboardRect);
     nameEntry.setDisplayRect(Rect(0, 0, gridWidth * blockSize, screen.bounds.h));
 
-    screen.sprites = Surface::load(asset_tetris_sprites);
-
-    channels[noiseChannel].waveforms = Waveform::NOISE;
-    channels[noiseChannel].frequency = 2000;
-    channels[noiseChannel].attack_ms = 5;
-    channels[noiseChannel].decay_ms = 150;
-    channels[noiseChannel].sustain = 0;
+    // everything else is loaded after the first frame
+    initTime = us_diff(startTime, now_us());
 }
 
 // drawing
 void render(uint32_t time) {
-    // "game" area (excliding info/leaderboard sidebar)
-    Rect leftRect(0, 0, gridWidth * blockSize, screen.bounds.h);
+    if(wallMode) {
+        renderWall();
+        return;
+    }
 
-    screen.pen = Pen(0, 0, 0);
-    screen.clear();
+    if(versusMode) {
+        versus.render();
+        return;
+    }
 
-    screen.pen = Pen(0xFF,0xFF,0xFF);
-    screen.rectangle(Rect(0, 0, gridWidth * blockSize, gridHeight * blockSize));
+    // last frame is still on screen
+    if(isScreenStatic() && !screenDirty)
+        return;
 
-    // skip row 0 (it's off the top of the screen)
-    for(int y = 1; y < gridHeight; y++) {
-        for(int x = 0; x < gridWidth; x++) {
-            if(grid[x + y * gridWidth] != 0) {
-                screen.sprite(grid[x + y * gridWidth] - 1, Point(x * blockSize, (y - 1) * blockSize - rowFalling[y] / rowFallScale));
-            }
-        }
-    }
+    if(!firstFrameTime)
+        firstFrameTime = us_diff(startTime, now_us());
 
-    //draw falling block
-    if(blockFalling.id != -1) {
-        auto &block = blocks[blockFalling.id];
+    screenDirty = false;
 
-        for(int y = 0; y < 2; y++) {
-            for(int x = 0; x < 4; x++) {
-                auto rotPos = blockFalling.pos + rotateIt(Point(x, y), block.width, block.height, blockFalling.rot);
+    // "game" area (excliding info/leaderboard sidebar)
+    Rect leftRect(0, 0, gridWidth * blockSize, screen.bounds.h);
 
-                if(block.pattern[y][x])
-                    screen.sprite(blockFalling.id, Point(rotPos.x * blockSize, (rotPos.y - 1) * blockSize));
-            }
-        }
-    }
+    screen.pen = Pen(0, 0, 0);
+    screen.clear();
 
-    // particles
-    for(auto &p : particles)
-        screen.sprite(p.sprite, Point(p.pos));
+    mainPlayer.render(Point(0, 0), blockSize);
 
     // game info
     if(gameStarted && !gameEnded) {
@@ -480,24 +334,29 @@ void render(uint32_t time) {
 
         screen.text("Score:", font, Point(x, y));
         if(narrow) y += 12;
-        screen.text(std::to_string(score), font, Rect(x, y, infoW, 8), true, TextAlign::top_right);
+        screen.text(std::to_string(board.getScore()), font, Rect(x, y, infoW, 8), true, TextAlign::top_right);
 
         y += 12;
         screen.text("Lines:", font, Point(x, y));
         if(narrow) y += 12;
-        screen.text(std::to_string(lines), font, Rect(x, y, infoW, 8), true, TextAlign::top_right);
+        screen.text(std::to_string(board.getLines()), font, Rect(x, y, infoW, 8), true, TextAlign::top_right);
 
         y += 12;
         screen.text("Next:", font, Point(x, y));
 
-        y += 8;
-        auto &block = blocks[nextBlock];
-        Point nextBlockPos(x + (infoW - block.width * blockSize) / 2, y + (24 - block.height * blockSize) / 2);
+        y += 10;
+
+        // preview queue, stacked
+        for(int i = 0; i < previewSize; i++) {
+            int nextBlock = board.getNextBlock(i);
+            auto &block = blocks[nextBlock];
+            Point nextBlockPos(x + (infoW - block.width * blockSize) / 2, y + i * (blockSize * 2 + 2));
 
-        for(int y = 0; y < block.height; y++) {
-            for(int x = 0; x < block.width; x++) {
-                if(block.pattern[y][x])
-                    screen.sprite(nextBlock, nextBlockPos + Point(x * blockSize, y * blockSize));
+            for(int y = 0; y < block.height; y++) {
+                for(int x = 0; x < block.width; x++) {
+                    if(block.hasTile(x, y))
+                        screen.sprite(nextBlock, nextBlockPos + Point(x * blockSize, y * blockSize));
+                }
             }
         }
 
@@ -523,7 +382,7 @@ void render(uint32_t time) {
             if(needNameEntry)
                 nameEntry.render();
             else if(!gameStarted)
-                screen.text("Press A!", font, leftRect, true, TextAlign::center_center);
+                screen.text("Press A!\n\nB: Watch\nUp: Versus", font, leftRect, true, TextAlign::center_center);
             else
                 screen.text("Game Over!\n\nPress A to\nrestart.", font, leftRect, true, TextAlign::center_center);
         }
@@ -533,127 +392,49 @@ void render(uint32_t time) {
 
         if(narrow)
             screen.text("X: Toggle Scores", font, Point(screen.bounds.w - 4, screen.bounds.h - 4), true, TextAlign::bottom_right);
-    }
-}
-
-static int autoDelay = 0;
-
-// brute force everything!
-
-// score based on Y coord of each tile in the pattern
-static int autoPlaceBlockScore(int blockId, Point pos, int rot) {
-    auto &block = blocks[blockId];
 
-    int score = 0;
-
-    for(int y = 0; y < block.height; y++) {
-        for(int x = 0; x < block.width; x++) {
-            if(!block.pattern[y][x])
-                continue;
-
-            Point rotPos = pos + rotateIt(Point(x, y), block.width, block.height, rot);
-
-            score += rotPos.y * rotPos.y;
-
-            // no further checks if touching the bottom
-            if(rotPos.y + 1 == gridHeight)
-                continue;
-
-            // work out which way is down in the rotated pattern
-            bool neg = rot > 1; // 2/3
-            int downX = (rot & 1) * (neg ? -1 : 1); // 1/3
-            int downY = ((~rot) & 1) * (neg ? -1 : 1); // 0/2
-
-            // check if there is a tile below this one in the pattern
-            if(x + downX >= 0 && x + downX < block.width && y + downY >= 0 && y + downY < block.height && block.pattern[y + downY][x + downX])
-                continue;
-
-            // reduce score if leaving a gap below
-            if(!grid[rotPos.x + (rotPos.y + 1) * gridWidth])
-                score -= rotPos.y * rotPos.y / 2;
-
-        }
+#ifdef ROLLOUT_PLANNER
+        if(!gameStarted)
+            screen.text(usePlanner ? "Y: Rollout bot" : "Y: Greedy bot", font, Point(4, screen.bounds.h - 4), true, TextAlign::bottom_left);
+#endif
     }
-
-    return score;
 }
 
-static void autoPlay() {
-
-    if(autoDelay) {
-        autoDelay--;
+void update(uint32_t time) {
+    // finish starting up before handling any input
+    if(startupStep != StartupStep::Done) {
+        continueStartup();
+        screenDirty = true;
         return;
     }
 
-    autoDelay = 15;
+    bool inputChanged = buttons.state != lastButtons;
+    lastButtons = buttons.state;
 
-    // "ai" player
-    int optX = 0, optRot = 0;
-
-    auto &block = blocks[blockFalling.id];
-
-    // attempt to place block as low as possible
-    int maxScore = -1;
-
-    auto savedPos = blockFalling.pos;
-
-    for(int rot = 0; rot < 4; rot++) {
-        for(int x = -3; x < gridWidth; x++) { // rotation can shift blocks to the right, so start a little to the left
-            for(int y = gridHeight - 1; y >= 0; y--) {
-                blockFalling.pos = Point(x, y);
-
-                // check (rotated) w/h
-                int w = block.width;
-                int h = block.height;
-
-                if(rot == 1 || rot == 3)
-                    std::swap(w, h);
-
-                if(x + w > gridWidth || y + h > gridHeight)
-                    continue;
-
-                if(!blockHitRot(rot, true)) {
-                    int score = autoPlaceBlockScore(blockFalling.id, {x, y}, rot);
-
-                    // check if lower (including offset from rotation)
-                    if(score <= maxScore)
-                        continue;
-
-                    // check if possible to drop here
-                    bool canDrop = true;
-                    while(canDrop && blockFalling.pos.y > 0) {
-                        blockFalling.pos.y--;
-                        canDrop = !blockHitRot(rot);
-                    }
+    if(isScreenStatic() && !inputChanged)
+        return;
 
-                    if(!canDrop)
-                        continue;
+    screenDirty = true;
 
-                    optX = x;
-                    maxScore = score;
-                    optRot = rot;
-                    break;
-                }
-            }
-        }
+    if(wallMode) {
+        updateWall();
+        return;
     }
 
-    blockFalling.pos = savedPos;
-
-    if(blockFalling.rot != optRot)
-        rotate = 1;
-    else if(optX > blockFalling.pos.x)
-        move = 1;
-    else if(optX < blockFalling.pos.x)
-        move = -1;
-}
-
-void update(uint32_t time) {
+    if(versusMode) {
+        if(!versus.update())
+            endVersus();
+        return;
+    }
 
     // toggle pause if MENU pressed while game started
-    if(gameStarted && !gameEnded && (buttons.released & Button::MENU))
+    if(gameStarted && !gameEnded && (buttons.released & Button::MENU)) {
         gamePaused = !gamePaused;
 
+        if(gamePaused)
+            saveGame();
+    }
+
     if(gamePaused)
         return;
 
@@ -669,7 +450,7 @@ void update(uint32_t time) {
             if(needNameEntry) {
                 // got name, update leaderboard
                 needNameEntry = false;
-                leaderboard.addScore(nameEntry.getName().c_str(), score);
+                leaderboard.addScore(nameEntry.getName().c_str(), board.getScore());
                 nameEntry.saveName();
             } else
                 reset(); // start new game;
@@ -679,113 +460,73 @@ void update(uint32_t time) {
         if((buttons.released & Button::X) && narrow)
             showLeaderboard = !showLeaderboard;
 
+#ifdef ROLLOUT_PLANNER
+        // switch auto-play bot
+        if((buttons.released & Button::Y) && !gameStarted) {
+            usePlanner = !usePlanner;
+            mainPlayer.setPlanner(usePlanner ? &planner : nullptr);
+        }
+#endif
+
+        if((buttons.released & Button::B) && !gameStarted && !needNameEntry) {
+            startWall();
+            return;
+        }
+
+        if((buttons.released & Button::DPAD_UP) && !gameStarted && !needNameEntry) {
+            startVersus();
+            return;
+        }
+
         if(gameEnded)
             return;
     }
 
-    if(checkLost()) {
+    if(board.checkLost()) {
         if(gameStarted){
             gameEnded = true;
+            saveGame();
+
+            telemetry.addGame(mainPlayer.getStats());
+            saveTelemetry();
 
             // get name if the score can be added
-            if(leaderboard.canAddScore(score)) {
+            if(leaderboard.canAddScore(board.getScore())) {
                 needNameEntry = true;
                 if(screen.bounds.w < 160)
                     showLeaderboard = false;
             }
         } else {
-            // reset auto-play
-            reset();
-            gameStarted = false;
-        }
-        return;
-    }
-
-    // update particles
-    for(auto it = particles.begin(); it != particles.end();) {
-        if(it->pos.y > screen.bounds.h) {
-            it = particles.erase(it);
-            continue;
-        }
-
-        it->pos += it->vel;
-        it->vel.y += 0.05f; // gravity
-
-        ++it;
-    }
+            // attract mode game, kept apart from the ones played by hand
+            telemetry.addGame(mainPlayer.getStats());
+            saveTelemetry();
 
-    // scroll down blocks after clearing lines
-    bool isFalling = false;
-    for(int i = 0; i < gridHeight; i++){
-        if(rowFalling[i]) {
-            rowFalling[i]--;
-            isFalling = true;
-
-            // play sound whenever a row stops falling
-            // this should check if the row above is non-empty...
-            if(!rowFalling[i])
-                playDropSound(0x7FFF);
+            resetAutoPlay();
         }
+        return;
     }
 
-    if(isFalling) return;
-
-    // input
-    if(!gameStarted) {
-        autoPlay();
-    } else {
-        if(buttons.pressed & Button::A)
-            rotate = 1;
-
-        if(buttons.pressed & Button::DPAD_LEFT)
-            move = -1;
-        else if(buttons.pressed & Button::DPAD_RIGHT)
-            move = 1;
-    }
-
-    if(blockFalling.id == -1) {
-        blockFalling.id = nextBlock;
-        blockFalling.timer = 0;
-        blockFalling.pos.y = -2;
-        blockFalling.pos.x = 5 - blocks[blockFalling.id].width / 2;
-        blockFalling.rot = 0;
+    PlayerInput input;
+    input.rotate = buttons.pressed & Button::A;
 
-        nextBlock = blit::random() % 7;
-    } else {
-        if(rotate != 0) {
-            int newRot = (blockFalling.rot + rotate) % 4;
-            if(!blockHitRot(newRot)) {
-                blockFalling.rot = newRot;
+    if(buttons.pressed & Button::DPAD_LEFT)
+        input.move = -1;
+    else if(buttons.pressed & Button::DPAD_RIGHT)
+        input.move = 1;
 
-                pushAwayFromSide();
-            }
+    input.softDrop = buttons & Button::DPAD_DOWN;
+    input.hardDrop = buttons.pressed & Button::DPAD_UP;
 
-            rotate = 0;
-        }
+    mainPlayer.update(input);
 
-        if(move != 0) {
-            if(!blockHitMove(move)) {
-                blockFalling.pos.x += move;
-                move = 0;
-            }
-        }
+    // play sound whenever a row stops falling
+    if(mainPlayer.hasRowLanded())
+        playDropSound(0x7FFF);
 
-        int time = buttons & Button::DPAD_DOWN ? fallTime / 4 : fallTime;
+    if(mainPlayer.hasBlockLanded()) {
+        playDropSound();
 
-        if(blockFalling.timer >= time) {
-            if(fallingBlockHit()) {
-                playDropSound();
-                placeBlock();
-
-                checkLine();
-
-                blockFalling.id = -1;
-            } else {
-                blockFalling.pos.y++;
-                blockFalling.timer = 0;
-            }
-        }
-        else
-            blockFalling.timer++;
+        if(gameStarted && ++blocksSinceSave >= snapshotSaveInterval)
+            saveGame();
     }
 }
\ No newline at end of file
@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <chrono>
+
+#include "planner.hpp"
+#include "xorshift.hpp"
+
+// anything that loses should be worse than any surviving board
+static const float lostValue = -10000.0f;
+
+static uint64_t nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+RolloutPlanner::RolloutPlanner(int numThreads) : pool(numThreads) {}
+
+void RolloutPlanner::setOptions(const PlannerOptions &options) {
+    pool.wait();
+    this->options = options;
+}
+
+void RolloutPlanner::start(const Board &board) {
+    pool.wait();
+
+    board.saveSnapshot(rootSnapshot);
+    startLines = board.getLines();
+
+    numCandidates = findPlacements(makeBitBoard(board), board.getFallingBlock().id, options.weights, candidates);
+
+    // greedy play within the preview is the same every time
+    bool deterministic = options.depth <= previewSize && options.policy == RolloutPolicy::Greedy;
+    int rollouts = numRollouts = deterministic ? std::min(options.rollouts, 1) : options.rollouts;
+
+    rolloutValues.assign(numCandidates * rollouts, 0.0f);
+
+    // different futures each time, but the same ones for every candidate
+    uint32_t baseSeed = options.seed + planCount++ * rollouts;
+
+    firstTaskStart = UINT64_MAX;
+    lastTaskEnd = 0;
+
+    for(int c = 0; c < numCandidates; c++) {
+        for(int r = 0; r < rollouts; r += rolloutsPerTask) {
+            int end = std::min(r + rolloutsPerTask, rollouts);
+
+            pool.submit([this, c, r, end, baseSeed]() {
+                runTask(c, r, end, baseSeed);
+            });
+        }
+    }
+}
+
+bool RolloutPlanner::isDone() const {
+    return pool.isIdle();
+}
+
+Placement RolloutPlanner::getResult() {
+    pool.wait();
+
+    Placement best;
+    int rollouts = numRollouts;
+
+    for(int c = 0; c < numCandidates; c++) {
+        float total = 0.0f;
+        for(int r = 0; r < rollouts; r++)
+            total += rolloutValues[c * rollouts + r];
+
+        float value = rollouts ? total / rollouts : candidates[c].score;
+
+        if(!best.valid || value > best.score) {
+            best = candidates[c];
+            best.score = value;
+        }
+    }
+
+    return best;
+}
+
+Placement RolloutPlanner::plan(const Board &board) {
+    start(board);
+    return getResult();
+}
+
+uint64_t RolloutPlanner::getNumSimulatedBlocks() const {
+    return simulatedBlocks;
+}
+
+uint32_t RolloutPlanner::getLastPlanTime() const {
+    uint64_t start = firstTaskStart, end = lastTaskEnd;
+
+    // no tasks
+    if(end < start)
+        return 0;
+
+    return uint32_t(end - start);
+}
+
+void RolloutPlanner::runTask(int candidate, int first, int end, uint32_t baseSeed) {
+    uint64_t startTime = nowUs();
+
+    uint64_t earliest = firstTaskStart;
+    while(startTime < earliest && !firstTaskStart.compare_exchange_weak(earliest, startTime));
+
+    for(int i = first; i < end; i++)
+        rolloutValues[candidate * numRollouts + i] = rollout(candidate, baseSeed + i);
+
+    uint64_t endTime = nowUs();
+
+    uint64_t latest = lastTaskEnd;
+    while(endTime > latest && !lastTaskEnd.compare_exchange_weak(latest, endTime));
+}
+
+float RolloutPlanner::rollout(int candidate, uint32_t seed) {
+    Board board;
+    board.loadSnapshot(rootSnapshot);
+
+    auto &placement = candidates[candidate];
+    board.dropBlock(placement.x, placement.rot);
+
+    // the preview is known, the blocks after it aren't
+    board.setRandomSeed(seed);
+
+    // for picking random placements
+    XorShift32 policyRandom;
+    policyRandom.seed(seed * 2654435761u + 1);
+
+    int played = 1;
+    bool lost = board.checkLost();
+
+    for(int i = 0; i < options.depth && !lost; i++, played++) {
+        if(options.policy == RolloutPolicy::Greedy)
+            lost = !playBestPlacement(board, options.weights);
+        else {
+            board.spawnBlock();
+
+            Placement placements[maxPlacements];
+            int count = findPlacements(makeBitBoard(board), board.getFallingBlock().id, options.weights, placements);
+
+            if(!count) {
+                lost = true;
+                break;
+            }
+
+            auto &chosen = placements[policyRandom.next() % count];
+            lost = !board.dropBlock(chosen.x, chosen.rot);
+        }
+
+        lost = lost || board.checkLost();
+    }
+
+    simulatedBlocks += played;
+
+    if(lost)
+        return lostValue;
+
+    return evaluateBoard(makeBitBoard(board), board.getLines() - startLines, options.weights);
+}
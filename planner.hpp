@@ -0,0 +1,67 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "ai.hpp"
+#include "board.hpp"
+#include "thread-pool.hpp"
+
+enum class RolloutPolicy {
+    Random, // any placement that doesn't lose
+    Greedy  // best placement by the evaluation weights
+};
+
+struct PlannerOptions {
+    int rollouts = 32; // per placement
+    int depth = 6;     // blocks played in each rollout, past the preview so they aren't all known
+    RolloutPolicy policy = RolloutPolicy::Greedy;
+    AIWeights weights;
+    uint32_t seed = 1;
+};
+
+// picks a placement for the falling block by playing out random futures for each one
+// much slower than findBestPlacement, but stronger
+class RolloutPlanner final {
+public:
+    RolloutPlanner(int numThreads = 0);
+
+    void setOptions(const PlannerOptions &options);
+
+    // starts planning in the background, the board is copied
+    void start(const Board &board);
+    bool isDone() const;
+
+    // waits if not done
+    Placement getResult();
+
+    Placement plan(const Board &board);
+
+    // total blocks played in rollouts
+    uint64_t getNumSimulatedBlocks() const;
+
+    // from the first task of the last plan starting to the last one finishing, in microseconds
+    uint32_t getLastPlanTime() const;
+
+private:
+    static const int rolloutsPerTask = 8;
+
+    float rollout(int candidate, uint32_t seed);
+    void runTask(int candidate, int first, int end, uint32_t baseSeed);
+
+    ThreadPool pool;
+    PlannerOptions options;
+
+    BoardSnapshot rootSnapshot;
+    int startLines = 0;
+
+    Placement candidates[maxPlacements];
+    int numCandidates = 0;
+
+    std::vector<float> rolloutValues;
+    int numRollouts = 0; // per candidate, for the current plan
+
+    uint32_t planCount = 0;
+    std::atomic<uint64_t> firstTaskStart{0}, lastTaskEnd{0};
+    std::atomic<uint64_t> simulatedBlocks{0};
+};
@@ -0,0 +1,345 @@
+#include <algorithm>
+
+#include "engine/engine.hpp"
+
+#include "player.hpp"
+
+using namespace blit;
+
+// main colour of each block sprite, for drawing at other sizes
+static const Pen blockColours[numBlocks]{
+    {255,   0,   0},
+    {255, 128,   0},
+    {255, 255,   0},
+    {  0, 255,   0},
+    {  0, 255, 255},
+    {  0,   0, 255},
+    {170,   0, 255}
+};
+
+static void drawBlock(int id, Point pos, int blockSize) {
+    if(blockSize == Player::spriteSize)
+        screen.sprite(id, pos);
+    else {
+        screen.pen = blockColours[id];
+        screen.rectangle(Rect(pos.x, pos.y, blockSize, blockSize));
+    }
+}
+
+void Player::reset(uint32_t seed) {
+    particleRandom.seed(~seed);
+
+    // generate particles for the old grid
+    for(int y = 0; y < gridHeight; y++) {
+        for(int x = 0; x < gridWidth; x++) {
+            if(board.getCell(x, y) != 0)
+                spawnParticle(x, y, board.getCell(x, y));
+        }
+    }
+
+    board.reset(seed);
+
+    stats = GameStats();
+    lastCombo = 0;
+
+    move = rotate = 0;
+    autoPlanned = false;
+#ifdef ROLLOUT_PLANNER
+    plannerStarted = false;
+#endif
+#ifdef DECISION_LOG
+    decisionStarted = false;
+    // the file is appended to across sessions, so number games by the records before them
+    decisionGame = decisionLog ? uint32_t(decisionLog->getNumRecords()) : 0;
+    decisionPiece = 0;
+#endif
+}
+
+void Player::update(const PlayerInput &input) {
+    blockLanded = rowLanded = false;
+
+    stats.ticks++;
+
+    // update particles
+    for(auto it = particles.begin(); it != particles.end();) {
+        if(it->pos.y > (gridHeight - 1) * spriteSize) {
+            it = particles.erase(it);
+            continue;
+        }
+
+        it->pos += it->vel;
+        it->vel.y += 0.05f; // gravity
+
+        ++it;
+    }
+
+    // scroll down blocks after clearing lines
+    if(board.updateRowFalling(rowLanded)) {
+        stats.rowFallingTicks++;
+        return;
+    }
+
+    // input
+    if(autoPlaying) {
+        autoPlay();
+    } else {
+        if(input.rotate)
+            rotate = 1;
+
+        if(input.move)
+            move = input.move;
+    }
+
+    if(board.getFallingBlock().id == -1) {
+        board.spawnBlock();
+
+        autoPlanned = false;
+#ifdef ROLLOUT_PLANNER
+        plannerStarted = false;
+#endif
+#ifdef DECISION_LOG
+        decisionStarted = decisionLog && !autoPlaying;
+        if(decisionStarted)
+            beginDecision(decision, board, decisionGame, decisionPiece);
+#endif
+    } else {
+        if(rotate != 0) {
+            board.rotateBlock(rotate);
+            rotate = 0;
+        }
+
+        if(move != 0) {
+            if(board.moveBlock(move))
+                move = 0;
+        }
+
+        int time = input.softDrop ? fallTime / 4 : fallTime;
+
+        bool landed = input.hardDrop && !autoPlaying ? board.hardDrop() : board.updateFalling(time);
+
+        if(landed) {
+            blockLanded = true;
+
+            updateStats();
+
+#ifdef DECISION_LOG
+            if(decisionStarted && decisionLog) {
+                endDecision(decision, board);
+                decisionLog->write(decision);
+                decisionStarted = false;
+            }
+            decisionPiece++;
+#endif
+
+            // particles!
+            for(int i = 0; i < board.getNumClearedRows(); i++) {
+                auto &row = board.getClearedRow(i);
+                for(int x = 0; x < gridWidth; x++)
+                    spawnParticle(x, row.y, row.cells[x]);
+            }
+        }
+    }
+}
+
+void Player::render(Point origin, int blockSize) const {
+    screen.pen = Pen(0xFF,0xFF,0xFF);
+    screen.rectangle(Rect(origin.x, origin.y, gridWidth * blockSize, (gridHeight - 1) * blockSize));
+
+    // skip row 0 (it's off the top of the screen)
+    for(int y = 1; y < gridHeight; y++) {
+        int offset = board.getRowFalling(y) * blockSize / Board::rowFallTime;
+
+        for(int x = 0; x < gridWidth; x++) {
+            if(board.getCell(x, y) != 0)
+                drawBlock(board.getCell(x, y) - 1, origin + Point(x * blockSize, (y - 1) * blockSize - offset), blockSize);
+        }
+    }
+
+    //draw falling block
+    auto &blockFalling = board.getFallingBlock();
+    if(blockFalling.id != -1) {
+        auto &block = blocks[blockFalling.id];
+
+        // ghost where it would land
+        if(!autoPlaying) {
+            auto ghostPos = Point(blockFalling.pos.x, board.getDropY());
+            auto &colour = blockColours[blockFalling.id];
+            screen.pen = Pen(colour.r, colour.g, colour.b, 96);
+
+            for(int y = 0; y < 2; y++) {
+                for(int x = 0; x < 4; x++) {
+                    auto rotPos = ghostPos + rotateIt(Point(x, y), block.width, block.height, blockFalling.rot);
+
+                    if(block.hasTile(x, y) && rotPos.y > 0)
+                        screen.rectangle(Rect(origin.x + rotPos.x * blockSize, origin.y + (rotPos.y - 1) * blockSize, blockSize, blockSize));
+                }
+            }
+        }
+
+        for(int y = 0; y < 2; y++) {
+            for(int x = 0; x < 4; x++) {
+                auto rotPos = blockFalling.pos + rotateIt(Point(x, y), block.width, block.height, blockFalling.rot);
+
+                if(block.hasTile(x, y))
+                    drawBlock(blockFalling.id, origin + Point(rotPos.x * blockSize, (rotPos.y - 1) * blockSize), blockSize);
+            }
+        }
+    }
+
+    // particles
+    for(auto &p : particles)
+        drawBlock(p.sprite, origin + Point(p.pos.x * blockSize / spriteSize, p.pos.y * blockSize / spriteSize), blockSize);
+}
+
+void Player::setAutoPlay(bool autoPlay) {
+    autoPlaying = autoPlay;
+}
+
+#ifdef ROLLOUT_PLANNER
+void Player::setPlanner(RolloutPlanner *planner) {
+    this->planner = planner;
+    plannerStarted = false;
+}
+#endif
+
+#ifdef DECISION_LOG
+void Player::setDecisionLog(DecisionWriter *log) {
+    decisionLog = log;
+    decisionStarted = false;
+    decisionGame = log ? uint32_t(log->getNumRecords()) : 0;
+}
+#endif
+
+Board &Player::getBoard() {
+    return board;
+}
+
+const Board &Player::getBoard() const {
+    return board;
+}
+
+bool Player::loadSnapshot(const BoardSnapshot &snapshot) {
+    if(!board.loadSnapshot(snapshot))
+        return false;
+
+    // the score carries over but nothing else does, so keep it out of per-game averages
+    stats = GameStats();
+    stats.resumed = 1;
+    lastCombo = 0;
+
+    autoPlanned = false;
+#ifdef ROLLOUT_PLANNER
+    plannerStarted = false;
+#endif
+#ifdef DECISION_LOG
+    decisionStarted = false;
+#endif
+    return true;
+}
+
+bool Player::hasBlockLanded() const {
+    return blockLanded;
+}
+
+bool Player::hasRowLanded() const {
+    return rowLanded;
+}
+
+GameStats Player::getStats() const {
+    auto ret = stats;
+    ret.score = board.getScore();
+    ret.autoPlayed = autoPlaying;
+
+    // count a combo that hasn't been broken yet
+    if(lastCombo >= 2)
+        ret.combos[std::min(lastCombo, 5) - 2]++;
+
+    return ret;
+}
+
+void Player::autoPlay() {
+
+    if(autoDelay) {
+        autoDelay--;
+        return;
+    }
+
+    autoDelay = 15;
+
+    auto &blockFalling = board.getFallingBlock();
+
+    if(blockFalling.id == -1)
+        return;
+
+    // "ai" player, pick a placement once per block and then steer towards it
+#ifdef ROLLOUT_PLANNER
+    if(!autoPlanned && planner) {
+        if(!plannerStarted) {
+            planner->start(board);
+            plannerStarted = true;
+        }
+
+        // keep falling while it thinks
+        if(!planner->isDone())
+            return;
+
+        autoTarget = planner->getResult();
+
+        // only the planner's own work, not the updates spent waiting to check on it
+        stats.aiTimeUs += planner->getLastPlanTime();
+        stats.aiDecisions++;
+        autoPlanned = true;
+        plannerStarted = false;
+    }
+#endif
+
+    if(!autoPlanned) {
+        auto startTime = now_us();
+
+        autoTarget = findBestPlacement(makeBitBoard(board), blockFalling.id, autoWeights);
+        autoPlanned = true;
+
+        stats.aiTimeUs += us_diff(startTime, now_us());
+        stats.aiDecisions++;
+    }
+
+    if(!autoTarget.valid)
+        return;
+
+    if(blockFalling.rot != autoTarget.rot)
+        rotate = 1;
+    else if(autoTarget.x > blockFalling.pos.x)
+        move = 1;
+    else if(autoTarget.x < blockFalling.pos.x)
+        move = -1;
+}
+
+void Player::updateStats() {
+    stats.pieces++;
+
+    int cleared = board.getNumClearedRows();
+    if(cleared)
+        stats.clears[cleared - 1]++;
+
+    // combo count goes up for each block in a row that clears lines, count it once it's broken
+    int combo = board.getCombo();
+
+    if(!cleared && lastCombo >= 2)
+        stats.combos[std::min(lastCombo, 5) - 2]++;
+
+    lastCombo = cleared ? combo : 0;
+    stats.maxCombo = std::max(int(stats.maxCombo), combo);
+
+    // before the clear, every cleared row was under the top of every column
+    for(int x = 0; x < gridWidth; x++)
+        stats.maxHeight = std::max(int(stats.maxHeight), board.getColumnHeight(x) + cleared);
+}
+
+void Player::spawnParticle(int x, int y, int cell) {
+    BlockParticle b;
+    b.pos = Vec2(x * spriteSize, (y - 1) * spriteSize);
+    b.vel.x = particleRandom.nextFloat() * 2.0f - 1.0f;
+    b.vel.y = particleRandom.nextFloat() * -1.0f;
+    b.sprite = cell - 1;
+    particles.push_back(b);
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include <list>
+
+#include "types/point.hpp"
+#include "types/vec2.hpp"
+
+#include "ai.hpp"
+#include "board.hpp"
+#include "telemetry.hpp"
+#include "xorshift.hpp"
+#ifdef ROLLOUT_PLANNER
+#include "planner.hpp"
+#endif
+#ifdef DECISION_LOG
+#include "decision-log.hpp"
+#endif
+
+struct PlayerInput {
+    int move = 0; // -1 left, 1 right
+    bool rotate = false;
+    bool softDrop = false;
+    bool hardDrop = false;
+};
+
+// a board with its input/auto-play, effects and drawing
+// the main game uses one, the spectator wall uses several
+class Player final {
+public:
+    static const int fallTime = 30;
+    static const int spriteSize = 8;
+    static const int maxPlayers = 8; // the main game and the spectator wall share these
+
+    // turns the old grid into particles
+    void reset(uint32_t seed);
+
+    // move/rotate input is ignored when auto-playing
+    void update(const PlayerInput &input);
+
+    // block sizes other than the sprite size are drawn as plain rectangles
+    void render(blit::Point origin, int blockSize) const;
+
+    void setAutoPlay(bool autoPlay);
+#ifdef ROLLOUT_PLANNER
+    // nullptr to use the greedy bot
+    void setPlanner(RolloutPlanner *planner);
+#endif
+#ifdef DECISION_LOG
+    // records the placements made while not auto-playing, nullptr to stop
+    void setDecisionLog(DecisionWriter *log);
+#endif
+
+    Board &getBoard();
+    const Board &getBoard() const;
+
+    // continues a saved game, the stats only count from here
+    bool loadSnapshot(const BoardSnapshot &snapshot);
+
+    // what happened in the last update, for sounds
+    bool hasBlockLanded() const;
+    bool hasRowLanded() const;
+
+    // since the last reset
+    GameStats getStats() const;
+
+private:
+    struct BlockParticle {
+        blit::Vec2 vel;
+        blit::Vec2 pos;
+        int sprite = 0;
+    };
+
+    void autoPlay();
+    void spawnParticle(int x, int y, int cell);
+    void updateStats();
+
+    Board board;
+
+    int move = 0, rotate = 0;
+
+    bool autoPlaying = false;
+    int autoDelay = 0;
+    bool autoPlanned = false;
+    Placement autoTarget;
+    AIWeights autoWeights;
+
+#ifdef ROLLOUT_PLANNER
+    RolloutPlanner *planner = nullptr;
+    bool plannerStarted = false;
+#endif
+
+#ifdef DECISION_LOG
+    DecisionWriter *decisionLog = nullptr;
+    DecisionRecord decision;
+    bool decisionStarted = false;
+    uint32_t decisionGame = 0; // records in the file when the game started
+    int decisionPiece = 0;
+#endif
+
+    GameStats stats;
+    int lastCombo = 0;
+
+    std::list<BlockParticle> particles;
+    XorShift32 particleRandom; // separate from the board so effects don't change the game
+
+    bool blockLanded = false, rowLanded = false;
+};
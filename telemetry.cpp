@@ -0,0 +1,89 @@
+#ifdef TELEMETRY_CSV
+#include <cstdio>
+#endif
+
+#include "engine/engine.hpp"
+#include "engine/save.hpp"
+
+#include "telemetry.hpp"
+
+using namespace blit;
+
+// updates are every 10ms
+static const float secondsPerTick = 0.01f;
+
+void Telemetry::load() {
+    SaveData loaded;
+
+    // start again if the layout changed
+    if(read_save(loaded, saveSlot) && loaded.version == currentVersion)
+        data = loaded;
+}
+
+void Telemetry::save() {
+    write_save(data, saveSlot);
+}
+
+void Telemetry::addGame(const GameStats &stats) {
+    if(stats.autoPlayed) {
+        data.autoGames[data.totalAutoGames % maxAutoGames] = stats;
+        data.totalAutoGames++;
+    } else {
+        data.games[data.totalGames % maxGames] = stats;
+        data.totalGames++;
+    }
+}
+
+int Telemetry::getNumGames(bool autoPlayed) const {
+    uint32_t total = getTotalGames(autoPlayed);
+    uint32_t max = autoPlayed ? maxAutoGames : maxGames;
+    return total < max ? total : max;
+}
+
+const GameStats &Telemetry::getGame(int i, bool autoPlayed) const {
+    uint32_t first = getTotalGames(autoPlayed) - getNumGames(autoPlayed);
+
+    if(autoPlayed)
+        return data.autoGames[(first + i) % maxAutoGames];
+
+    return data.games[(first + i) % maxGames];
+}
+
+uint32_t Telemetry::getTotalGames(bool autoPlayed) const {
+    return autoPlayed ? data.totalAutoGames : data.totalGames;
+}
+
+#ifdef TELEMETRY_CSV
+bool Telemetry::exportCSV(const char *path) const {
+    auto file = fopen(path, "w");
+    if(!file)
+        return false;
+
+    fprintf(file, "game,auto,resumed,score,pieces,seconds,pieces_per_second,singles,doubles,triples,tetrises,tetris_rate,"
+                  "max_combo,combos_2,combos_3,combos_4,combos_5_plus,max_height,row_falling_seconds,ai_decisions,ai_average_us\n");
+
+    // hand played then auto-played, the game number counts within each
+    for(bool autoPlayed : {false, true}) {
+        uint32_t first = getTotalGames(autoPlayed) - getNumGames(autoPlayed);
+
+        for(int i = 0; i < getNumGames(autoPlayed); i++) {
+            auto &game = getGame(i, autoPlayed);
+
+            float seconds = game.ticks * secondsPerTick;
+            int numClears = game.clears[0] + game.clears[1] + game.clears[2] + game.clears[3];
+
+            fprintf(file, "%u,%i,%i,%u,%u,%.2f,%.3f,%i,%i,%i,%i,%.3f,%i,%i,%i,%i,%i,%i,%.2f,%i,%u\n",
+                unsigned(first + i), game.autoPlayed, game.resumed, unsigned(game.score), unsigned(game.pieces),
+                double(seconds), seconds > 0.0f ? double(game.pieces / seconds) : 0.0,
+                game.clears[0], game.clears[1], game.clears[2], game.clears[3],
+                numClears ? double(game.clears[3]) / numClears : 0.0,
+                game.maxCombo, game.combos[0], game.combos[1], game.combos[2], game.combos[3],
+                game.maxHeight, double(game.rowFallingTicks * secondsPerTick),
+                game.aiDecisions, game.aiDecisions ? unsigned(game.aiTimeUs / game.aiDecisions) : 0u);
+        }
+    }
+
+    fclose(file);
+    return true;
+}
+#endif
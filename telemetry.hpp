@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+
+// what happened in one game, filled in by Player as it plays
+struct GameStats {
+    uint32_t score = 0;
+    uint32_t pieces = 0;
+    uint32_t ticks = 0;            // updates while playing, not paused
+    uint32_t rowFallingTicks = 0;  // updates spent waiting for cleared rows to fall
+    uint32_t aiTimeUs = 0;         // total time picking placements
+    uint16_t aiDecisions = 0;
+    uint16_t clears[4]{0};         // number of 1, 2, 3 and 4 line clears
+    uint16_t combos[4]{0};         // number of combos of 2, 3, 4 and 5+ clears in a row
+    uint8_t maxCombo = 0;
+    uint8_t maxHeight = 0;
+    uint8_t autoPlayed = 0;
+    uint8_t resumed = 0;           // continued from a saved game, so only the score covers the whole game
+    uint8_t reserved[2]{0};
+};
+
+static_assert(sizeof(GameStats) == 44, "GameStats should not have padding");
+
+// the last few games on the main board, saved with the leaderboard
+// auto-played games are kept apart so they can't push out the ones played by hand
+class Telemetry final {
+public:
+    static const int maxGames = 32;
+    static const int maxAutoGames = 8;
+
+    void load();
+    void save();
+
+    // goes in the auto-played games if stats.autoPlayed is set
+    void addGame(const GameStats &stats);
+
+    // 0 is the oldest game still kept
+    int getNumGames(bool autoPlayed = false) const;
+    const GameStats &getGame(int i, bool autoPlayed = false) const;
+
+    // counting games that have been overwritten
+    uint32_t getTotalGames(bool autoPlayed = false) const;
+
+#ifdef TELEMETRY_CSV
+    bool exportCSV(const char *path) const;
+#endif
+
+private:
+    static const int saveSlot = 2;
+    static const uint16_t currentVersion = 3;
+
+    struct SaveData {
+        uint16_t version = currentVersion;
+        uint16_t reserved = 0;
+        uint32_t totalGames = 0;
+        uint32_t totalAutoGames = 0;
+        GameStats games[maxGames];
+        GameStats autoGames[maxAutoGames];
+    };
+
+    SaveData data;
+};
@@ -0,0 +1,105 @@
+#include <algorithm>
+
+#include "thread-pool.hpp"
+
+ThreadPool::ThreadPool(int numThreads) {
+    if(numThreads <= 0)
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    for(int i = 0; i < numThreads; i++)
+        queues.emplace_back(new Queue);
+
+    for(int i = 0; i < numThreads; i++)
+        threads.emplace_back(&ThreadPool::workerMain, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(waitMutex);
+        quit = true;
+    }
+
+    taskAdded.notify_all();
+
+    for(auto &thread : threads)
+        thread.join();
+}
+
+void ThreadPool::submit(Task task) {
+    pendingTasks++;
+
+    // spread new tasks over the queues, anything uneven gets stolen
+    auto &queue = *queues[nextQueue++ % queues.size()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(waitMutex);
+        queuedTasks++;
+    }
+
+    taskAdded.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(waitMutex);
+    tasksDone.wait(lock, [this]{return pendingTasks == 0;});
+}
+
+bool ThreadPool::isIdle() const {
+    return pendingTasks == 0;
+}
+
+int ThreadPool::getNumThreads() const {
+    return int(threads.size());
+}
+
+void ThreadPool::workerMain(int index) {
+    while(true) {
+        Task task;
+
+        if(popTask(index, task)) {
+            task();
+
+            if(--pendingTasks == 0) {
+                std::lock_guard<std::mutex> lock(waitMutex);
+                tasksDone.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(waitMutex);
+        taskAdded.wait(lock, [this]{return quit || queuedTasks > 0;});
+
+        if(quit && queuedTasks == 0)
+            return;
+    }
+}
+
+bool ThreadPool::popTask(int index, Task &task) {
+    int numQueues = int(queues.size());
+
+    // own queue from the front, others from the back
+    for(int i = 0; i < numQueues; i++) {
+        auto &queue = *queues[(index + i) % numQueues];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        if(queue.tasks.empty())
+            continue;
+
+        if(i == 0) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        } else {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+
+        queuedTasks--;
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// each worker has its own queue and steals from the others when it runs out
+class ThreadPool final {
+public:
+    using Task = std::function<void()>;
+
+    ThreadPool(int numThreads = 0); // 0 = one per core
+    ~ThreadPool();
+
+    void submit(Task task);
+
+    // waits for every submitted task to finish
+    void wait();
+
+    bool isIdle() const;
+
+    int getNumThreads() const;
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void workerMain(int index);
+    bool popTask(int index, Task &task);
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+
+    std::mutex waitMutex;
+    std::condition_variable taskAdded, tasksDone;
+
+    std::atomic<int> queuedTasks{0};  // in a queue
+    std::atomic<int> pendingTasks{0}; // queued or running
+    std::atomic<unsigned int> nextQueue{0};
+    bool quit = false;
+};
@@ -0,0 +1,97 @@
+// plays the same seeded games with the greedy bot and the rollout planner
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "ai.hpp"
+#include "board.hpp"
+#include "planner.hpp"
+
+struct Options {
+    int games = 8;
+    int maxPieces = 1000;
+    int threads = 0;
+    uint32_t seed = 1;
+    PlannerOptions planner;
+};
+
+static void usage(const char *name) {
+    printf("usage: %s [options]\n", name);
+    printf("  --games N       games per bot (8)\n");
+    printf("  --max-pieces N  pieces before a game is stopped (1000)\n");
+    printf("  --threads N     planner worker threads (all cores)\n");
+    printf("  --seed N        first game seed (1)\n");
+    printf("  --rollouts N    rollouts per placement (32)\n");
+    printf("  --depth N       blocks per rollout (6)\n");
+    printf("  --random        random rollout policy instead of greedy\n");
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+
+    for(int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+
+        if(strcmp(argv[i], "--games") == 0 && hasValue)
+            options.games = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--max-pieces") == 0 && hasValue)
+            options.maxPieces = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--threads") == 0 && hasValue)
+            options.threads = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--seed") == 0 && hasValue)
+            options.seed = strtoul(argv[++i], nullptr, 0);
+        else if(strcmp(argv[i], "--rollouts") == 0 && hasValue)
+            options.planner.rollouts = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--depth") == 0 && hasValue)
+            options.planner.depth = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--random") == 0)
+            options.planner.policy = RolloutPolicy::Random;
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    RolloutPlanner planner(options.threads);
+    planner.setOptions(options.planner);
+
+    for(int usePlanner = 0; usePlanner < 2; usePlanner++) {
+        auto startTime = std::chrono::steady_clock::now();
+        long totalLines = 0, totalPieces = 0;
+
+        for(int game = 0; game < options.games; game++) {
+            Board board;
+            board.reset(options.seed + game);
+
+            int pieces = 0;
+            for(; pieces < options.maxPieces && !board.checkLost(); pieces++) {
+                if(!usePlanner) {
+                    if(!playBestPlacement(board, options.planner.weights))
+                        break;
+                    continue;
+                }
+
+                board.spawnBlock();
+                auto placement = planner.plan(board);
+
+                if(!placement.valid || !board.dropBlock(placement.x, placement.rot))
+                    break;
+            }
+
+            printf("%s game %i: %i lines, %i pieces\n", usePlanner ? "planner" : "greedy", game, board.getLines(), pieces);
+
+            totalLines += board.getLines();
+            totalPieces += pieces;
+        }
+
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+        printf("%s: %.1f lines/game, %.1f pieces/s\n", usePlanner ? "planner" : "greedy", double(totalLines) / options.games, totalPieces / elapsed);
+    }
+
+    double blocks = double(planner.getNumSimulatedBlocks());
+    printf("planner simulated %.0f blocks\n", blocks);
+
+    return 0;
+}
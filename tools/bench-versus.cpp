@@ -0,0 +1,116 @@
+// headless bot vs bot matches with garbage, for measuring the whole simulation/AI pipeline
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "ai.hpp"
+#include "board.hpp"
+#include "thread-pool.hpp"
+
+struct Options {
+    int matches = 64;
+    int maxPieces = 2000;
+    int threads = 0;
+    uint32_t seed = 1;
+};
+
+struct MatchResult {
+    int winner = -1; // -1 if neither lost
+    int pieces = 0;
+    int garbage = 0;
+};
+
+static MatchResult playMatch(uint32_t seed, int maxPieces) {
+    AIWeights weights;
+    Board boards[2];
+
+    boards[0].reset(seed * 2);
+    boards[1].reset(seed * 2 + 1);
+
+    MatchResult result;
+
+    // both place a block, then swap garbage
+    while(result.pieces < maxPieces) {
+        for(int i = 0; i < 2; i++) {
+            if(!playBestPlacement(boards[i], weights) || boards[i].checkLost()) {
+                result.winner = 1 - i;
+                return result;
+            }
+            result.pieces++;
+        }
+
+        for(int i = 0; i < 2; i++) {
+            int sent = boards[i].getGarbageSent();
+            boards[1 - i].addGarbage(sent);
+            result.garbage += sent;
+        }
+    }
+
+    return result;
+}
+
+static void usage(const char *name) {
+    printf("usage: %s [options]\n", name);
+    printf("  --matches N     matches to play (64)\n");
+    printf("  --max-pieces N  pieces before a match is a draw (2000)\n");
+    printf("  --threads N     worker threads (all cores)\n");
+    printf("  --seed N        first match seed (1)\n");
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+
+    for(int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+
+        if(strcmp(argv[i], "--matches") == 0 && hasValue)
+            options.matches = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--max-pieces") == 0 && hasValue)
+            options.maxPieces = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--threads") == 0 && hasValue)
+            options.threads = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--seed") == 0 && hasValue)
+            options.seed = strtoul(argv[++i], nullptr, 0);
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    ThreadPool pool(options.threads);
+    std::vector<MatchResult> results(options.matches);
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    for(int i = 0; i < options.matches; i++) {
+        pool.submit([&results, &options, i]() {
+            results[i] = playMatch(options.seed + i, options.maxPieces);
+        });
+    }
+
+    pool.wait();
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    int wins[2]{0, 0}, draws = 0;
+    long pieces = 0, garbage = 0;
+
+    for(auto &result : results) {
+        if(result.winner == -1)
+            draws++;
+        else
+            wins[result.winner]++;
+
+        pieces += result.pieces;
+        garbage += result.garbage;
+    }
+
+    printf("%i matches on %i threads in %.2fs\n", options.matches, pool.getNumThreads(), elapsed);
+    printf("wins: %i / %i, draws: %i\n", wins[0], wins[1], draws);
+    printf("%.1f pieces/match, %.1f garbage rows/match\n", double(pieces) / options.matches, double(garbage) / options.matches);
+    printf("%.1f matches/s, %.0f pieces/s\n", options.matches / elapsed, pieces / elapsed);
+
+    return 0;
+}
@@ -0,0 +1,336 @@
+// finds the best placement for board positions read from a file or stdin, using the game's AI
+//
+// text input, one position per line:
+//   <rows> <queue>
+//   rows are the bottom of the board, top to bottom, separated by '/', '.' is empty and anything else filled
+//   queue is the falling block then any next blocks as letters from "ZLOSIJT"
+//   e.g. "........../#.###.####/########.. IT"
+// text output, one line per input line: "<x> <rot> <y> <lines> <score>", or "none" if there's nowhere
+// to place the block or the line couldn't be parsed (blank lines are "none" without an error)
+//
+// binary input (--binary) is a decision file (see decision-log.hpp), using the block and next block of each record
+// binary output is an EvalResult per record, linesCleared is -1 if the record's block isn't valid
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "ai.hpp"
+#include "decision-log.hpp"
+#include "thread-pool.hpp"
+
+static const char *blockLetters = "ZLOSIJT";
+
+struct Position {
+    BitBoard board;
+    int8_t queue[2];
+    int queueLength = 0;
+};
+
+struct EvalResult {
+    float score;
+    int8_t x, rot, y;
+    int8_t linesCleared; // -1 if there's nowhere to place the block
+};
+
+static_assert(sizeof(EvalResult) == 8, "EvalResult should not have padding");
+
+struct Options {
+    bool binary = false;
+    bool lookahead = false;
+    int threads = 0;
+    int batch = 65536;
+    AIWeights weights;
+    const char *in = "-";
+    const char *out = "-";
+};
+
+static bool parseLine(const std::string &line, Position &position) {
+    auto space = line.find(' ');
+    if(space == std::string::npos)
+        return false;
+
+    // rows, the last one is the bottom
+    std::vector<RowMask> rows;
+    RowMask row = 0;
+    int x = 0;
+
+    for(size_t i = 0; i <= space; i++) {
+        if(i == space || line[i] == '/') {
+            if(x != gridWidth)
+                return false;
+
+            rows.push_back(row);
+            row = 0;
+            x = 0;
+        } else if(x < gridWidth) {
+            if(line[i] != '.')
+                row |= RowMask(1) << x;
+            x++;
+        } else
+            return false;
+    }
+
+    if(rows.size() > size_t(gridHeight))
+        return false;
+
+    position.board = BitBoard();
+    int top = gridHeight - rows.size();
+    for(size_t i = 0; i < rows.size(); i++)
+        position.board.rows[top + i] = rows[i];
+
+    position.queueLength = 0;
+
+    for(size_t i = space + 1; i < line.size() && position.queueLength < 2; i++) {
+        auto letter = strchr(blockLetters, line[i]);
+        if(!letter || !*letter)
+            return false;
+
+        position.queue[position.queueLength++] = letter - blockLetters;
+    }
+
+    return position.queueLength > 0;
+}
+
+static EvalResult evaluatePosition(const Position &position, const Options &options) {
+    EvalResult result{0.0f, 0, 0, 0, -1};
+    bool resultHasNext = false; // scores with and without the next block aren't comparable
+
+    Placement placements[maxPlacements];
+    int count = findPlacements(position.board, position.queue[0], options.weights, placements);
+
+    bool lookahead = options.lookahead && position.queueLength > 1;
+
+    for(int i = 0; i < count; i++) {
+        auto &placement = placements[i];
+
+        BitBoard placed = position.board;
+        int cleared = applyPlacement(placed, position.queue[0], placement);
+
+        float score = placement.score;
+        bool hasNext = false;
+
+        // score by the best placement for the next block instead
+        if(lookahead) {
+            auto next = findBestPlacement(placed, position.queue[1], options.weights);
+
+            // can't place the next block, only pick this if there's nothing else
+            if(!next.valid && result.linesCleared != -1)
+                continue;
+
+            if(next.valid) {
+                score = next.score + cleared * options.weights.lines;
+                hasNext = true;
+            }
+        }
+
+        bool better = hasNext != resultHasNext ? hasNext : score > result.score;
+
+        if(result.linesCleared == -1 || better) {
+            resultHasNext = hasNext;
+            result.score = score;
+            result.x = placement.x;
+            result.rot = placement.rot;
+            result.y = placement.y;
+            result.linesCleared = cleared;
+        }
+    }
+
+    return result;
+}
+
+static bool parseWeights(const char *str, AIWeights &weights) {
+    float values[6];
+    if(sscanf(str, "%f,%f,%f,%f,%f,%f", &values[0], &values[1], &values[2], &values[3], &values[4], &values[5]) != 6)
+        return false;
+
+    weights.height = values[0];
+    weights.holes = values[1];
+    weights.rowTransitions = values[2];
+    weights.bumpiness = values[3];
+    weights.wells = values[4];
+    weights.lines = values[5];
+    return true;
+}
+
+static void usage(const char *name) {
+    printf("usage: %s [options] [input] [output]\n", name);
+    printf("  input/output default to stdin/stdout\n");
+    printf("  --binary        decision file in, EvalResults out\n");
+    printf("  --lookahead     also try each placement of the second block in the queue\n");
+    printf("  --weights LIST  height,holes,rowTransitions,bumpiness,wells,lines\n");
+    printf("  --threads N     worker threads (all cores)\n");
+    printf("  --batch N       positions read before evaluating (65536)\n");
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+    int numFiles = 0;
+
+    for(int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+
+        if(strcmp(argv[i], "--binary") == 0)
+            options.binary = true;
+        else if(strcmp(argv[i], "--lookahead") == 0)
+            options.lookahead = true;
+        else if(strcmp(argv[i], "--weights") == 0 && hasValue) {
+            if(!parseWeights(argv[++i], options.weights)) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if(strcmp(argv[i], "--threads") == 0 && hasValue)
+            options.threads = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--batch") == 0 && hasValue)
+            options.batch = std::max(1, atoi(argv[++i]));
+        else if(argv[i][0] != '-' || strcmp(argv[i], "-") == 0) {
+            if(numFiles == 0)
+                options.in = argv[i];
+            else if(numFiles == 1)
+                options.out = argv[i];
+            else {
+                usage(argv[0]);
+                return 1;
+            }
+            numFiles++;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    bool inStdin = strcmp(options.in, "-") == 0, outStdout = strcmp(options.out, "-") == 0;
+
+    FILE *inFile = inStdin ? stdin : fopen(options.in, "rb");
+    FILE *outFile = outStdout ? stdout : fopen(options.out, options.binary ? "wb" : "w");
+
+    if(!inFile || !outFile) {
+        fprintf(stderr, "couldn't open %s\n", !inFile ? options.in : options.out);
+        return 1;
+    }
+
+    if(options.binary) {
+        DecisionFileHeader header, expected;
+        expected.recordSize = sizeof(DecisionRecord);
+
+        if(fread(&header, sizeof(header), 1, inFile) != 1 || memcmp(&header, &expected, sizeof(header)) != 0) {
+            fprintf(stderr, "%s isn't a decision file with this board size\n", options.in);
+            return 1;
+        }
+    }
+
+    ThreadPool pool(options.threads);
+
+    std::vector<Position> positions(options.batch);
+    std::vector<EvalResult> results(options.batch);
+    std::vector<DecisionRecord> records(options.binary ? options.batch : 0);
+    std::vector<bool> parsed(options.batch);
+
+    // only used for text
+    std::ifstream inStream;
+    if(!options.binary && !inStdin)
+        inStream.open(options.in);
+    std::istream &textIn = inStdin ? std::cin : inStream;
+
+    int lineNum = 0, badLines = 0;
+    long total = 0;
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    while(true) {
+        // read a batch
+        int count = 0;
+
+        if(options.binary) {
+            count = fread(records.data(), sizeof(DecisionRecord), options.batch, inFile);
+
+            for(int i = 0; i < count; i++) {
+                auto &position = positions[i];
+                auto &record = records[i];
+                memcpy(position.board.rows, record.rows, sizeof(position.board.rows));
+                position.queue[0] = record.blockId;
+                position.queue[1] = record.nextBlock;
+
+                // only look ahead if the next block is valid too
+                bool nextValid = record.nextBlock >= 0 && record.nextBlock < numBlocks;
+                position.queueLength = nextValid ? 2 : 1;
+
+                parsed[i] = record.blockId >= 0 && record.blockId < numBlocks;
+
+                if(!parsed[i]) {
+                    fprintf(stderr, "record %li: bad block %i\n", total + i, record.blockId);
+                    badLines++;
+                }
+            }
+        } else {
+            std::string line;
+            while(count < options.batch && std::getline(textIn, line)) {
+                lineNum++;
+
+                parsed[count] = parseLine(line, positions[count]);
+
+                if(!parsed[count] && !line.empty()) {
+                    fprintf(stderr, "line %i: can't parse \"%s\"\n", lineNum, line.c_str());
+                    badLines++;
+                }
+
+                count++;
+            }
+        }
+
+        if(count == 0)
+            break;
+
+        // evaluate in parallel
+        const int positionsPerTask = 256;
+
+        for(int start = 0; start < count; start += positionsPerTask) {
+            int end = std::min(start + positionsPerTask, count);
+
+            pool.submit([&, start, end]() {
+                for(int i = start; i < end; i++) {
+                    if(parsed[i])
+                        results[i] = evaluatePosition(positions[i], options);
+                    else
+                        results[i] = EvalResult{0.0f, 0, 0, 0, -1};
+                }
+            });
+        }
+
+        pool.wait();
+
+        // write out in order
+        if(options.binary)
+            fwrite(results.data(), sizeof(EvalResult), count, outFile);
+        else {
+            for(int i = 0; i < count; i++) {
+                auto &result = results[i];
+                if(result.linesCleared == -1)
+                    fprintf(outFile, "none\n");
+                else
+                    fprintf(outFile, "%i %i %i %i %g\n", result.x, result.rot, result.y, result.linesCleared, double(result.score));
+            }
+        }
+
+        total += count;
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    fprintf(stderr, "%li positions in %.2fs on %i threads (%.0f/s)", total, elapsed, pool.getNumThreads(), total / elapsed);
+    if(badLines)
+        fprintf(stderr, ", %i couldn't be parsed", badLines);
+    fprintf(stderr, "\n");
+
+    if(!inStdin)
+        fclose(inFile);
+    if(!outStdout)
+        fclose(outFile);
+
+    return badLines ? 2 : 0;
+}
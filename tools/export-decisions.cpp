@@ -0,0 +1,125 @@
+// plays seeded games with the greedy bot and writes every placement to a decision file
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include "ai.hpp"
+#include "board.hpp"
+#include "decision-log.hpp"
+#include "thread-pool.hpp"
+
+struct Options {
+    int games = 64;
+    int maxPieces = 10000;
+    int threads = 0;
+    uint32_t seed = 1;
+    const char *out = "decisions.fbdl";
+};
+
+// returns the number of records
+static int playGame(uint32_t seed, int maxPieces, DecisionRecord *records) {
+    AIWeights weights;
+    Board board;
+    board.reset(seed);
+
+    int piece = 0;
+
+    for(; piece < maxPieces; piece++) {
+        board.spawnBlock();
+
+        // the game is numbered once its place in the file is known
+        auto &record = records[piece];
+        beginDecision(record, board, 0, piece);
+
+        auto placement = findBestPlacement(makeBitBoard(board), board.getFallingBlock().id, weights);
+
+        if(!placement.valid || !board.dropBlock(placement.x, placement.rot))
+            break;
+
+        endDecision(record, board);
+
+        if(board.checkLost()) {
+            piece++;
+            break;
+        }
+    }
+
+    return piece;
+}
+
+static void usage(const char *name) {
+    printf("usage: %s [options]\n", name);
+    printf("  --games N       games to play (64)\n");
+    printf("  --max-pieces N  pieces before a game is stopped (10000)\n");
+    printf("  --threads N     worker threads (all cores)\n");
+    printf("  --seed N        first game seed (1)\n");
+    printf("  --out FILE      file to append to (decisions.fbdl)\n");
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+
+    for(int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+
+        if(strcmp(argv[i], "--games") == 0 && hasValue)
+            options.games = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--max-pieces") == 0 && hasValue)
+            options.maxPieces = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--threads") == 0 && hasValue)
+            options.threads = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--seed") == 0 && hasValue)
+            options.seed = strtoul(argv[++i], nullptr, 0);
+        else if(strcmp(argv[i], "--out") == 0 && hasValue)
+            options.out = argv[++i];
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    DecisionWriter writer;
+    if(!writer.open(options.out)) {
+        fprintf(stderr, "couldn't open %s (or it has a different record format)\n", options.out);
+        return 1;
+    }
+
+    auto startRecords = writer.getNumRecords();
+
+    ThreadPool pool(options.threads);
+    std::mutex writerMutex;
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    // each game fills its own records, then appends them all at once
+    for(int i = 0; i < options.games; i++) {
+        pool.submit([&, i]() {
+            std::vector<DecisionRecord> records(options.maxPieces);
+            int count = playGame(options.seed + i, options.maxPieces, records.data());
+
+            std::lock_guard<std::mutex> lock(writerMutex);
+
+            // same numbering as the game uses, the records already in the file
+            uint32_t game = writer.getNumRecords();
+            for(int r = 0; r < count; r++)
+                records[r].game = game;
+
+            writer.write(records.data(), count);
+        });
+    }
+
+    pool.wait();
+    writer.close();
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    auto written = writer.getNumRecords() - startRecords;
+
+    printf("%llu records from %i games in %.2fs on %i threads\n", (unsigned long long)written, options.games, elapsed, pool.getNumThreads());
+    printf("%.0f records/s, %.1f MB/s\n", written / elapsed, written * sizeof(DecisionRecord) / elapsed / (1024 * 1024));
+    printf("%s now has %llu records\n", options.out, (unsigned long long)writer.getNumRecords());
+
+    return 0;
+}
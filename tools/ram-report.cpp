@@ -0,0 +1,53 @@
+// prints how much RAM each part of a game uses
+#include <cstdio>
+
+#include "ai.hpp"
+#include "blocks.hpp"
+#include "board.hpp"
+#include "decision-log.hpp"
+#include "player.hpp"
+#include "telemetry.hpp"
+#include "versus.hpp"
+
+static void row(const char *name, size_t size, const char *note = "") {
+    printf("  %-24s %5zu  %s\n", name, size, note);
+}
+
+int main() {
+    printf("per board:\n");
+    row("Board", sizeof(Board));
+    row("  grid", gridWidth * gridHeight / 2, "4 bits per cell");
+    row("  falling block", sizeof(FallingBlock));
+    row("  preview and bag", previewSize + 1, "1 byte per block, 1 bit per bag block");
+    row("  column heights", gridWidth, "1 byte per column");
+    row("  row animation", gridHeight, "1 byte per row");
+    row("  cleared rows", sizeof(Board::ClearedRow) * 4, "for particles");
+
+    // without the Linux only planner/decision log members
+    printf("\nper player (particles are on the heap):\n");
+    row("Player", sizeof(Player));
+    row("  Board", sizeof(Board));
+    row("  GameStats", sizeof(GameStats));
+    row("  AI target/weights", sizeof(Placement) + sizeof(AIWeights));
+
+    printf("\ngame statics:\n");
+    size_t total = sizeof(Player) * Player::maxPlayers + sizeof(Versus) + sizeof(Telemetry);
+    row("total", total, "game.cpp asserts this is within 6KB");
+    row("  main/wall players", sizeof(Player) * Player::maxPlayers, "Player::maxPlayers");
+    row("  Versus", sizeof(Versus), "two more players");
+    row("  Telemetry", sizeof(Telemetry), "GameStats ring buffers, by hand and auto-played");
+    row("  DecisionWriter", sizeof(DecisionWriter), "Linux only, not in the total");
+
+    printf("\nsaved/cloned:\n");
+    row("BoardSnapshot", sizeof(BoardSnapshot), "3 bits per cell");
+
+    printf("\nshared:\n");
+    row("blocks", sizeof(blocks));
+
+    printf("\nAI scratch (stack):\n");
+    row("BitBoard", sizeof(BitBoard));
+    row("placements", sizeof(Placement) * maxPlacements);
+    row("AIWeights", sizeof(AIWeights));
+
+    return 0;
+}
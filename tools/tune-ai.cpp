@@ -0,0 +1,313 @@
+// tunes AIWeights by playing lots of headless games
+// uses the cross-entropy method: sample a population around the current mean,
+// play each candidate on the same set of seeds and move towards the best ones
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ai.hpp"
+#include "board.hpp"
+
+static const int numWeights = 6;
+
+static float AIWeights::*const weightMembers[numWeights]{
+    &AIWeights::height,
+    &AIWeights::holes,
+    &AIWeights::rowTransitions,
+    &AIWeights::bumpiness,
+    &AIWeights::wells,
+    &AIWeights::lines
+};
+
+static const char *const weightNames[numWeights]{
+    "height", "holes", "rowTransitions", "bumpiness", "wells", "lines"
+};
+
+struct Options {
+    int generations = 50;
+    int population = 64;
+    int elite = 8;
+    int games = 16;
+    int maxPieces = 5000;
+    int threads = 0;
+    uint32_t seed = 1;
+    std::string checkpoint = "tune-ai.txt";
+    bool resume = false;
+};
+
+struct Population {
+    int generation = 0;
+    float mean[numWeights];
+    float stdDev[numWeights];
+
+    float bestFitness = -1.0f;
+    float best[numWeights];
+
+    // last generation, kept for the checkpoint
+    std::vector<std::vector<float>> candidates;
+    std::vector<float> fitness;
+};
+
+struct GameResult {
+    int lines = 0;
+    int pieces = 0;
+};
+
+static AIWeights toWeights(const float *values) {
+    AIWeights weights;
+    for(int i = 0; i < numWeights; i++)
+        weights.*weightMembers[i] = values[i];
+
+    return weights;
+}
+
+static GameResult playGame(const AIWeights &weights, uint32_t seed, int maxPieces) {
+    Board board;
+    board.reset(seed);
+
+    GameResult result;
+
+    for(; result.pieces < maxPieces && !board.checkLost(); result.pieces++) {
+        if(!playBestPlacement(board, weights))
+            break;
+    }
+
+    result.lines = board.getLines();
+    return result;
+}
+
+static bool saveCheckpoint(const Population &pop, const std::string &filename) {
+    // write to a temp file first so an interrupted save doesn't lose the old one
+    auto tmpName = filename + ".tmp";
+    auto file = fopen(tmpName.c_str(), "w");
+
+    if(!file)
+        return false;
+
+    fprintf(file, "generation %i\n", pop.generation);
+    fprintf(file, "bestFitness %f\n", double(pop.bestFitness));
+
+    for(int i = 0; i < numWeights; i++)
+        fprintf(file, "weight %s %f %f %f\n", weightNames[i], double(pop.mean[i]), double(pop.stdDev[i]), double(pop.best[i]));
+
+    for(size_t c = 0; c < pop.candidates.size(); c++) {
+        fprintf(file, "candidate %f", double(pop.fitness[c]));
+        for(auto &w : pop.candidates[c])
+            fprintf(file, " %f", double(w));
+        fprintf(file, "\n");
+    }
+
+    fclose(file);
+
+    return rename(tmpName.c_str(), filename.c_str()) == 0;
+}
+
+static bool loadCheckpoint(Population &pop, const std::string &filename) {
+    auto file = fopen(filename.c_str(), "r");
+
+    if(!file)
+        return false;
+
+    char key[32], name[32];
+    int found = 0;
+
+    while(fscanf(file, "%31s", key) == 1) {
+        if(strcmp(key, "generation") == 0)
+            found += fscanf(file, "%i", &pop.generation) == 1;
+        else if(strcmp(key, "bestFitness") == 0)
+            found += fscanf(file, "%f", &pop.bestFitness) == 1;
+        else if(strcmp(key, "weight") == 0) {
+            float mean, stdDev, best;
+            if(fscanf(file, "%31s %f %f %f", name, &mean, &stdDev, &best) != 4)
+                break;
+
+            for(int i = 0; i < numWeights; i++) {
+                if(strcmp(name, weightNames[i]) == 0) {
+                    pop.mean[i] = mean;
+                    pop.stdDev[i] = stdDev;
+                    pop.best[i] = best;
+                    found++;
+                }
+            }
+        } else {
+            // skip the rest of the line
+            int c;
+            while((c = fgetc(file)) != EOF && c != '\n');
+        }
+    }
+
+    fclose(file);
+
+    return found == numWeights + 2;
+}
+
+static void usage(const char *name) {
+    printf("usage: %s [options]\n", name);
+    printf("  --generations N  generations to run (50)\n");
+    printf("  --population N   candidates per generation (64)\n");
+    printf("  --elite N        best candidates used for the next generation (8)\n");
+    printf("  --games N        games played by each candidate (16)\n");
+    printf("  --max-pieces N   pieces before a game is stopped (5000)\n");
+    printf("  --threads N      worker threads (all cores)\n");
+    printf("  --seed N         base seed for games and sampling (1)\n");
+    printf("  --checkpoint F   file to save progress to (tune-ai.txt)\n");
+    printf("  --resume         continue from the checkpoint\n");
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+
+    for(int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+
+        if(strcmp(argv[i], "--generations") == 0 && hasValue)
+            options.generations = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--population") == 0 && hasValue)
+            options.population = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--elite") == 0 && hasValue)
+            options.elite = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--games") == 0 && hasValue)
+            options.games = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--max-pieces") == 0 && hasValue)
+            options.maxPieces = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--threads") == 0 && hasValue)
+            options.threads = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--seed") == 0 && hasValue)
+            options.seed = strtoul(argv[++i], nullptr, 0);
+        else if(strcmp(argv[i], "--checkpoint") == 0 && hasValue)
+            options.checkpoint = argv[++i];
+        else if(strcmp(argv[i], "--resume") == 0)
+            options.resume = true;
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if(options.threads <= 0)
+        options.threads = std::max(1u, std::thread::hardware_concurrency());
+
+    options.elite = std::max(1, std::min(options.elite, options.population));
+
+    Population pop;
+
+    // start from the built-in weights
+    AIWeights defaults;
+    for(int i = 0; i < numWeights; i++) {
+        pop.mean[i] = pop.best[i] = defaults.*weightMembers[i];
+        pop.stdDev[i] = 0.5f;
+    }
+
+    if(options.resume) {
+        if(!loadCheckpoint(pop, options.checkpoint)) {
+            fprintf(stderr, "failed to load checkpoint %s\n", options.checkpoint.c_str());
+            return 1;
+        }
+        printf("resuming from generation %i\n", pop.generation);
+    }
+
+    std::mt19937 sampleRand(options.seed + pop.generation);
+
+    int numJobs = options.population * options.games;
+    std::vector<GameResult> results(numJobs);
+
+    for(; pop.generation < options.generations; pop.generation++) {
+        // sample candidates
+        pop.candidates.assign(options.population, std::vector<float>(numWeights));
+
+        for(auto &candidate : pop.candidates) {
+            for(int i = 0; i < numWeights; i++)
+                candidate[i] = std::normal_distribution<float>(pop.mean[i], pop.stdDev[i])(sampleRand);
+        }
+
+        // play every (candidate, game) pair, all candidates get the same seeds
+        auto startTime = std::chrono::steady_clock::now();
+        uint32_t genSeed = options.seed * 1000003u + pop.generation * options.games;
+
+        std::atomic<int> nextJob(0);
+        std::vector<std::thread> workers;
+
+        for(int t = 0; t < options.threads; t++) {
+            workers.emplace_back([&]() {
+                int job;
+                while((job = nextJob++) < numJobs) {
+                    auto weights = toWeights(pop.candidates[job / options.games].data());
+                    results[job] = playGame(weights, genSeed + job % options.games, options.maxPieces);
+                }
+            });
+        }
+
+        for(auto &worker : workers)
+            worker.join();
+
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+        // average lines per game
+        long totalPieces = 0;
+        pop.fitness.assign(options.population, 0.0f);
+
+        for(int job = 0; job < numJobs; job++) {
+            pop.fitness[job / options.games] += results[job].lines;
+            totalPieces += results[job].pieces;
+        }
+
+        for(auto &f : pop.fitness)
+            f /= options.games;
+
+        // pick the elite
+        std::vector<int> order(options.population);
+        for(int i = 0; i < options.population; i++)
+            order[i] = i;
+
+        std::sort(order.begin(), order.end(), [&pop](int a, int b) {return pop.fitness[a] > pop.fitness[b];});
+
+        if(pop.fitness[order[0]] > pop.bestFitness) {
+            pop.bestFitness = pop.fitness[order[0]];
+            for(int i = 0; i < numWeights; i++)
+                pop.best[i] = pop.candidates[order[0]][i];
+        }
+
+        // extra noise that decays over time, stops collapsing too early
+        float noise = 0.1f / (pop.generation + 1);
+
+        for(int i = 0; i < numWeights; i++) {
+            float mean = 0.0f;
+            for(int e = 0; e < options.elite; e++)
+                mean += pop.candidates[order[e]][i];
+            mean /= options.elite;
+
+            float variance = 0.0f;
+            for(int e = 0; e < options.elite; e++) {
+                float d = pop.candidates[order[e]][i] - mean;
+                variance += d * d;
+            }
+            variance /= options.elite;
+
+            pop.mean[i] = mean;
+            pop.stdDev[i] = std::sqrt(variance + noise);
+        }
+
+        printf("generation %i: best %.1f, elite worst %.1f, %.1f pieces/s\n", pop.generation,
+            double(pop.fitness[order[0]]), double(pop.fitness[order[options.elite - 1]]), totalPieces / elapsed);
+
+        // the generation is finished, so the checkpoint should start at the next one
+        pop.generation++;
+        if(!saveCheckpoint(pop, options.checkpoint))
+            fprintf(stderr, "failed to save checkpoint %s\n", options.checkpoint.c_str());
+        pop.generation--;
+    }
+
+    printf("\nbest (%.1f lines):\n", double(pop.bestFitness));
+    for(int i = 0; i < numWeights; i++)
+        printf("    float %s = %ff;\n", weightNames[i], double(pop.best[i]));
+
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include "engine/api.hpp"
+#include "engine/engine.hpp"
+
+#include "versus.hpp"
+
+using namespace blit;
+
+Versus::Versus(const Font &font) : font(font) {}
+
+void Versus::start(bool humanPlayer) {
+    this->humanPlayer = humanPlayer;
+    winner = -1;
+
+    for(auto &player : players)
+        player.reset(blit::random());
+
+    players[0].setAutoPlay(!humanPlayer);
+    players[1].setAutoPlay(true);
+}
+
+bool Versus::update() {
+    if(buttons.released & (Button::B | Button::MENU))
+        return false;
+
+    // switch between playing and watching
+    if(buttons.released & Button::Y) {
+        start(!humanPlayer);
+        return true;
+    }
+
+    if(winner != -1) {
+        if(buttons.released & Button::A)
+            start(humanPlayer);
+        return true;
+    }
+
+    auto startTime = now_us();
+
+    PlayerInput input;
+
+    if(humanPlayer) {
+        input.rotate = buttons.pressed & Button::A;
+
+        if(buttons.pressed & Button::DPAD_LEFT)
+            input.move = -1;
+        else if(buttons.pressed & Button::DPAD_RIGHT)
+            input.move = 1;
+
+        input.softDrop = buttons & Button::DPAD_DOWN;
+        input.hardDrop = buttons.pressed & Button::DPAD_UP;
+    }
+
+    for(int i = 0; i < 2; i++) {
+        if(players[i].getBoard().checkLost()) {
+            winner = 1 - i;
+            return true;
+        }
+    }
+
+    players[0].update(input);
+    players[1].update(PlayerInput());
+
+    // send garbage
+    for(int i = 0; i < 2; i++) {
+        if(players[i].hasBlockLanded())
+            players[1 - i].getBoard().addGarbage(players[i].getBoard().getGarbageSent());
+    }
+
+    updateTime = us_diff(startTime, now_us());
+
+    return true;
+}
+
+void Versus::render() {
+    screen.pen = Pen(0, 0, 0);
+    screen.clear();
+
+    int blockSize = Player::spriteSize;
+    int boardW = gridWidth * blockSize, boardH = (gridHeight - 1) * blockSize;
+    int y = (screen.bounds.h - boardH) / 2;
+
+    const char *names[]{humanPlayer ? "You" : "Bot 1", humanPlayer ? "Bot" : "Bot 2"};
+
+    for(int i = 0; i < 2; i++) {
+        // centered in each half
+        int x = (screen.bounds.w / 2 - boardW) / 2 + i * screen.bounds.w / 2;
+        auto &board = players[i].getBoard();
+
+        screen.clip = Rect(x, y, boardW, boardH);
+        players[i].render(Point(x, y), blockSize);
+        screen.clip = Rect(Point(0, 0), screen.bounds);
+
+        screen.pen = Pen(0xFF, 0xFF, 0xFF);
+        screen.text(names[i], font, Rect(x, y - font.char_h - 4, boardW, font.char_h), true, TextAlign::top_center);
+
+        std::string info = std::to_string(board.getLines()) + " lines";
+        if(board.getPendingGarbage())
+            info += " +" + std::to_string(board.getPendingGarbage());
+
+        screen.text(info, font, Rect(x, y + boardH + 4, boardW, font.char_h), true, TextAlign::top_center);
+    }
+
+    if(!humanPlayer)
+        screen.text(std::to_string(updateTime) + "us", font, Point(screen.bounds.w / 2, screen.bounds.h - 4), true, TextAlign::bottom_center);
+
+    if(winner != -1) {
+        screen.pen = Pen(0, 0, 0, 200);
+        screen.rectangle(Rect(Point(0, 0), screen.bounds));
+
+        screen.pen = Pen(0xFF, 0xFF, 0xFF);
+        std::string message = humanPlayer && winner == 0 ? "You win!" : std::string(names[winner]) + " wins!";
+        message += "\n\nA: Rematch\nB: Back";
+        screen.text(message, font, Rect(Point(0, 0), screen.bounds), true, TextAlign::center_center);
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "graphics/font.hpp"
+
+#include "player.hpp"
+
+// two boards side by side, clearing lines sends garbage to the other one
+// left is the player or a bot, right is always a bot
+class Versus final {
+public:
+    Versus(const blit::Font &font);
+
+    void start(bool humanPlayer);
+
+    // returns false when leaving
+    bool update();
+
+    void render();
+
+private:
+    const blit::Font &font;
+
+    Player players[2];
+    bool humanPlayer = true;
+    int winner = -1;
+
+    uint32_t updateTime = 0; // us, shown for bot vs bot
+};
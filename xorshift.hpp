@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+
+// small, fast and deterministic, each game has its own so it can be replayed or run alongside others
+struct XorShift32 {
+    uint32_t state = 1;
+
+    void seed(uint32_t seed) {
+        // gets stuck on 0
+        state = seed ? seed : 1;
+    }
+
+    uint32_t next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    // 0 to 1
+    float nextFloat() {
+        return next() / 4294967296.0f;
+    }
+};